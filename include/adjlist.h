@@ -2,6 +2,7 @@
 #define ADJLIST_H
 
 #include <histg_lib.h>
+#include <arena.h>
 
 typedef struct AdjListEdge
 {
@@ -22,6 +23,7 @@ typedef struct AdjListEdgeArray
 
 AdjListEdgeArray *alea_with_capacity(unsigned int capacity);
 AdjListEdgeArray *alea_new();
+AdjListEdgeArray *alea_in_arena(Arena *arena, unsigned int capacity);
 AdjListEdge *add_edge_alea(AdjListEdgeArray *alea, AdjListEdge edge);
 void free_alea(AdjListEdgeArray *alea);
 
@@ -42,6 +44,7 @@ typedef struct AdjListNeighbourArray
 
 AdjListNeighbourArray alna_with_capacity(unsigned int capacity);
 AdjListNeighbourArray alna_new();
+AdjListNeighbourArray alna_in_arena(Arena *arena, unsigned int capacity);
 void add_neighbour_alna(AdjListNeighbourArray *alna, AdjListNeighbour neighbour);
 void free_alna(AdjListNeighbourArray *alna, unsigned int array_count);
 
@@ -49,28 +52,59 @@ typedef struct AdjListGraph
 {
     // Static value storing the number of vertices in the graph, not considering any hidden vertices
     unsigned int vertices;
-    // Static bitset storing the available vertices
+    // Bitset storing the available vertices, only changed by hiding/unhiding vertices
     uint64_t available_vertices;
-    // Static value storing the number of available vertices in the graph
+    // Number of available vertices in the graph, only changed by hiding/unhiding vertices
     unsigned int nb_available_vertices;
     // Static array storing all the edges belonging to this graph/tree-combo
     // Each edge has flags storing whether it is: removed/selected
+    // Edges incident to hidden vertices are kept but flagged as removed
     AdjListEdgeArray *edges;
     // Static array of AdjListNeighbourArrays to store the neighbours for each vertex
     // Length == vertices
     AdjListNeighbourArray *neighbours;
     // Dynamic value storing the number of selected edges
     unsigned int d_nb_tree_edges;
+    // Dynamic value storing the number of edges that are not removed, selected ones included
+    unsigned int d_nb_graph_edges;
     // Dynamic array storing the degrees for the vertices in the graph
     unsigned int *d_graph_degrees;
     // Dynamic array storing the degrees for the vertices in the tree
     unsigned int *d_tree_degrees;
+    // Dynamic array storing for every vertex the bitset of its neighbours through edges that are not removed
+    uint64_t *d_graph_adjacencies;
     // Dynamic bitset storing the vertices where the tree can be extended
     uint64_t extendable_vertices;
+    // Dynamic bounds on the degree sum of any HIST completing the tree, which has to be 2(n - 1):
+    // every vertex needs tree degree 1, or 3 once it has 2, and can get at most its graph degree, or 1 if that is 2
+    unsigned int d_min_degree_sum;
+    unsigned int d_max_degree_sum;
+    // Arena owning all storage above, NULL when the storage belongs to an AdjListWorkspace
+    Arena *arena;
 } AdjListGraph;
 
 AdjListGraph *alg_from_graph_and_hidden(Graph *graph, uint64_t hidden_vertices);
 void free_alg(AdjListGraph *graph);
+
+// Reusable storage for constructing AdjListGraphs.
+// The arena keeps its capacity between constructions, so building a graph of a size
+// that has been seen before performs no heap allocations.
+// One workspace should be used per thread.
+typedef struct AdjListWorkspace
+{
+    Arena arena;
+    AdjListGraph graph;
+} AdjListWorkspace;
+
+AdjListWorkspace *alw_new();
+void free_alw(AdjListWorkspace *workspace);
+// The returned graph lives in the workspace and stays valid until the next construction,
+// it must not be passed to free_alg
+AdjListGraph *alg_from_graph_and_hidden_ws(AdjListWorkspace *workspace, Graph *graph, uint64_t hidden_vertices);
+
+// Hide or restore a vertex in place in O(deg v), only valid while no search is in progress
+void alg_hide_vertex(AdjListGraph *graph, unsigned int vertex);
+void alg_unhide_vertex(AdjListGraph *graph, unsigned int vertex);
 Graph *get_tree(AdjListGraph *alg);
 
 void add_edge_to_graph_alg(AdjListGraph *graph, AdjListEdge *edge);
@@ -83,12 +117,186 @@ bool is_valid_hist_alg(AdjListGraph *graph);
 
 bool get_next_edge_alg(AdjListGraph *graph, AdjListEdge **out_edge, bool *out_both_in_tree);
 
-void add_edge_alg(AdjListGraph *graph, AdjListEdge *edge, Output *output, bool find_one, RunData *run_data);
-void remove_edge_alg(AdjListGraph *graph, AdjListEdge *edge, Output *output, bool find_one, RunData *run_data);
-void hists_alg(AdjListGraph *graph, Output *output, bool find_one, RunData *run_data);
+bool hist_impossible(AdjListGraph *graph, AdjListEdge *edge);
+// Whether removing the edge would disconnect the graph of the edges that are not removed
+bool alg_is_bridge(AdjListGraph *graph, AdjListEdge *edge);
+
+typedef enum AdjListTrailOperation
+{
+    TrailTreeAdd,
+    TrailGraphRemove,
+} AdjListTrailOperation;
+
+// Single change made to the graph by the search
+typedef struct AdjListTrailEntry
+{
+    AdjListEdge *edge;
+    AdjListTrailOperation operation;
+} AdjListTrailEntry;
+
+typedef struct AdjListDecision
+{
+    AdjListEdge *edge;
+    // Trail size before the decision was applied, undoing to it reverts the decision
+    unsigned int trail_start;
+    // False while exploring the branch where edge is in the tree,
+    // true while exploring the branch where edge is removed from the graph
+    bool removing;
+    // The edge is a bridge, removing it can't lead to a spanning tree so there is no second branch
+    bool forced;
+} AdjListDecision;
+
+// Longest nogood kept in the store, and number of nogoods kept before the oldest one is replaced
+#define NOGOOD_MAX_LITERALS 32
+#define NOGOOD_SLOTS 4096
+
+// Decisions that together leave no HIST. A literal is 2 * edge index, plus 1 if the edge is removed
+// rather than in the tree. Only the watched literal is checked when it becomes true, and it is moved to
+// another literal that doesn't hold yet, so the nogood is violated once the watch can't be moved.
+typedef struct AdjListNogood
+{
+    unsigned int literals[NOGOOD_MAX_LITERALS];
+    unsigned int size;
+    unsigned int watched;
+    // Neighbours in the watch list of the watched literal, -1 at the ends
+    int previous;
+    int next;
+} AdjListNogood;
+
+/*
+ * Conflict analysis for searches that only need to know whether there is a HIST.
+ * Every change the propagation forces is stored with the decided edges that forced it. When a branch
+ * fails, the check that failed lists the edges responsible for it, and following the forced changes back
+ * gives the set of decisions the failure depends on. The search then jumps back to the deepest of those
+ * decisions instead of the last one, and the decisions themselves are stored as a nogood that cuts the
+ * search wherever they are made again in a different order.
+ */
+typedef struct AdjListLearning
+{
+    // Cleared once a HIST is found, the search below it is then no longer a failure
+    bool active;
+    // Number of words in a set of decisions, stored as a bitset of decision indices
+    unsigned int words;
+    // Trail position of the last change to every edge, only valid while the trail still holds that edge there
+    unsigned int *positions;
+    // For every trail position the decision it belongs to and the edges that forced it,
+    // decisions themselves have no reason
+    unsigned int *levels;
+    unsigned int *reason_starts;
+    unsigned int *reason_sizes;
+    AdjListEdge **reasons;
+    unsigned int nb_reasons;
+    unsigned int reasons_capacity;
+    // Start of the reason of the next change pushed on the trail
+    unsigned int pending_reason;
+    // Edges whose current state leaves no HIST, filled by the check that failed
+    AdjListEdge **conflict;
+    unsigned int conflict_size;
+    // Decisions the finished branch of every decision failed on, and the set of the current failure
+    uint64_t *branch_sets;
+    uint64_t *failure;
+    bool *seen;
+    AdjListNogood *nogoods;
+    unsigned long long int nb_nogoods;
+    // Head of the watch list of every literal, -1 when empty
+    int *watches;
+} AdjListLearning;
+
+// Most undecided edges left to the endgame, which tries all their subsets of the right size
+#define HIST_ENDGAME_EDGES 8
+
+/*
+ * Endgame of a branch with few undecided edges left.
+ * Rather than deciding them one at a time, every subset with as many edges as the tree still needs is
+ * tested with bitset operations: the tree degree an endpoint ends up with is its current one plus the
+ * popcount of the subset and its incidence mask, and the subset has to join the components of the tree
+ * without a cycle. Subsets are visited in increasing order, so a later call resumes where the last HIST was.
+ */
+typedef struct HistEndgame
+{
+    bool active;
+    AdjListEdge *edges[HIST_ENDGAME_EDGES];
+    unsigned int nb_edges;
+    // Component of the tree each endpoint of every edge belongs to
+    unsigned int components[HIST_ENDGAME_EDGES][2];
+    // Endpoints of the edges with their current tree degree and a bitset of the edges incident to them
+    unsigned int nb_vertices;
+    unsigned int tree_degrees[2 * HIST_ENDGAME_EDGES];
+    uint32_t incidences[2 * HIST_ENDGAME_EDGES];
+    // Next subset to test, the search below the endgame is done once it passes the last one
+    uint32_t subset;
+    uint32_t last;
+} HistEndgame;
+
+typedef struct HistIterator HistIterator;
+
+// Branching strategy of the search: picks the next undecided edge at a vertex where the tree can grow,
+// or at any vertex while the tree is empty. Every choice of such an edge keeps the search complete.
+typedef struct HistBranching
+{
+    const char *name;
+    bool (*next_edge)(HistIterator *iterator, AdjListEdge **out_edge, bool *out_both_in_tree);
+} HistBranching;
+
+// min-degree: smallest graph degree for both endpoints, as get_next_edge_alg
+// index: smallest vertex and first undecided edge
+// constrained: fewest undecided edges for both endpoints
+// grow: vertices of tree degree 2 first, which have to get another edge
+// risk: vertices most likely to end at tree degree 2 first, tree degree 2 and then graph degree 3
+// weighted: most failures per undecided edge, every failed branch adds weight to the endpoints of its decision
+extern const HistBranching HIST_BRANCHINGS[];
+extern const unsigned int NB_HIST_BRANCHINGS;
+// NULL if there is no strategy with the name
+const HistBranching *hist_branching_by_name(const char *name);
+// min-degree, used by every search that isn't given a strategy
+extern const HistBranching *const hist_default_branching;
+
+// Resumable search for HISTs in an AdjListGraph.
+// The decision stack and trail fully describe the position of the search,
+// all changes are made in place on the graph and undone when backtracking.
+struct HistIterator
+{
+    AdjListGraph *graph;
+    unsigned int capacity;
+    AdjListTrailEntry *trail;
+    unsigned int trail_size;
+    AdjListDecision *decisions;
+    unsigned int nb_decisions;
+    bool started;
+    bool exhausted;
+    // Number of finished trees/HISTs encountered since the last reset,
+    // trees the endgame rejects for their degrees are not counted
+    unsigned long long int trees;
+    unsigned long long int hists;
+    // NULL unless learning was enabled
+    AdjListLearning *learning;
+    // Number of failed branches since the last reset, the search stops as interrupted
+    // once it exceeds the limit unless that is 0
+    unsigned long long int failures;
+    unsigned long long int failure_limit;
+    bool interrupted;
+    const HistBranching *branching;
+    // Failures every vertex took part in since the last reset, plus one
+    unsigned int *weights;
+    HistEndgame endgame;
+};
+
+void hist_iter_init(HistIterator *iterator, AdjListGraph *graph, const HistBranching *branching);
+// Enables conflict analysis, backjumping and nogoods. Pays off when looking for a single HIST in a graph
+// that has few or none, once a HIST is found the rest of the run searches without them.
+void hist_iter_learn(HistIterator *iterator);
+bool hist_iter_next(HistIterator *iterator, Graph *tree);
+void hist_iter_reset(HistIterator *iterator);
+void free_hist_iter(HistIterator *iterator);
+
+void fill_tree(AdjListGraph *alg, Graph *tree);
+void hists_alg(AdjListGraph *graph, const HistBranching *branching, Output *output, bool find_one, RunData *run_data);
 
 bool is_hypohist_partials_alg(Graph *input_graph, Output *output, RunData *run_data);
 bool is_hypohist_alg(Graph *input_graph, Output *output, bool only_partials, RunData *run_data);
+bool run_hists_alg(AdjListGraph *graph, const HistBranching *branching, Output *output, bool find_one, RunData *run_data);
 bool find_hists_alg(Graph *input_graph, uint64_t hidden_vertices, Output *output, bool find_one, RunData *run_data);
+// Same as find_hists_alg with the given branching strategy, building the graph in the workspace
+bool find_hists_alg_ws(AdjListWorkspace *workspace, Graph *input_graph, uint64_t hidden_vertices, const HistBranching *branching, Output *output, bool find_one, RunData *run_data);
 
 #endif
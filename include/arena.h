@@ -0,0 +1,24 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// Bump allocator handing out storage from a single block.
+// Memory is only given back as a whole through arena_reset or free_arena,
+// pointers handed out stay valid until then.
+typedef struct Arena
+{
+    unsigned char *data;
+    size_t size;
+    size_t capacity;
+} Arena;
+
+Arena arena_new();
+size_t arena_aligned_size(size_t bytes);
+void arena_reserve(Arena *arena, size_t capacity);
+void *arena_alloc(Arena *arena, size_t bytes);
+void *arena_calloc(Arena *arena, size_t count, size_t size);
+void arena_reset(Arena *arena);
+void free_arena(Arena *arena);
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef BIGNAT_H
+#define BIGNAT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Enough for the product of all modular primes
+#define BIGNAT_LIMBS 8
+// Longest decimal representation of a BigNat, including the terminating null character
+#define BIGNAT_STRING_LENGTH 160
+
+// Fixed size natural number, limbs are stored least significant first
+typedef struct BigNat
+{
+    uint64_t limbs[BIGNAT_LIMBS];
+} BigNat;
+
+BigNat bignat_from_u64(uint64_t value);
+
+bool bignat_is_zero(BigNat *number);
+// Returns false if the number does not fit in 64 bits
+bool bignat_to_u64(BigNat *number, uint64_t *value);
+
+void bignat_add_u64(BigNat *number, uint64_t value);
+void bignat_mul_u64(BigNat *number, uint64_t value);
+void bignat_add(BigNat *number, const BigNat *other);
+// The other number must not be larger than the number
+void bignat_sub(BigNat *number, const BigNat *other);
+void bignat_mul(BigNat *number, const BigNat *other);
+// Negative, zero or positive like strcmp
+int bignat_compare(const BigNat *a, const BigNat *b);
+// Divides in place and returns the remainder
+uint64_t bignat_divmod_u64(BigNat *number, uint64_t divisor);
+
+// Parses a decimal number, returns false if the string is not a number or does not fit
+bool bignat_from_string(const char *string, BigNat *number);
+// Writes the decimal representation, buffer needs BIGNAT_STRING_LENGTH characters
+void bignat_to_string(BigNat *number, char *buffer);
+
+#endif
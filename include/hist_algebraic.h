@@ -0,0 +1,21 @@
+#ifndef HIST_ALGEBRAIC_H
+#define HIST_ALGEBRAIC_H
+
+#include <histg_lib.h>
+#include <bignat.h>
+
+// Largest number of determinant evaluations per prime that count_hists_algebraic accepts
+#define ALGEBRAIC_MAX_EVALUATIONS (1ULL << 22)
+
+// Number of determinant evaluations per prime needed for the graph, capped at ALGEBRAIC_MAX_EVALUATIONS + 1
+unsigned long long int algebraic_evaluations(Graph *graph);
+
+// Counts HISTs without enumerating trees. With edge weights x_u x_v the Matrix-Tree theorem gives
+// the polynomial sum_T prod_v x_v^deg_T(v). Every variable is evaluated at deg_G(v) points whose
+// weights map x^d to 0 for d = 2 and to 1 otherwise, all primes are combined by CRT.
+// Returns false without counting if the graph needs more than ALGEBRAIC_MAX_EVALUATIONS evaluations.
+// The product of the degrees grows too fast for dense graphs, K9 is already over the limit, and the search
+// counts the graphs below it far faster, so this is only used by histg -a to verify the other counts.
+bool count_hists_algebraic(Graph *graph, BigNat *count);
+
+#endif
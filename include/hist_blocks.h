@@ -0,0 +1,17 @@
+#ifndef HIST_BLOCKS_H
+#define HIST_BLOCKS_H
+
+#include <histg_lib.h>
+#include <bignat.h>
+
+// Largest number of cut vertices a block may share with exactly one other block, each doubles the searches
+#define BLOCKS_MAX_SHARED 10
+
+// Counts HISTs by dynamic programming over the block-cut tree. A spanning tree is a spanning tree of every
+// block, and a cut vertex only has tree degree 2 if it lies in exactly two blocks with tree degree 1 in both.
+// Every block is searched once for each way of forcing tree degree 1 or at least 2 on the cut vertices it
+// shares with a single other block. Returns false if the graph has no cut vertex, or a block has too many
+// shared cut vertices or too many vertices once the cut vertices are padded with leaves.
+bool count_hists_blocks(Graph *graph, BigNat *count);
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef HIST_COMPONENTS_H
+#define HIST_COMPONENTS_H
+
+#include <histg_lib.h>
+#include <adjlist.h>
+#include <bignat.h>
+
+// Largest number of residual parts whose counts are remembered
+#define COMPONENT_CACHE_SIZE (1 << 19)
+
+// Counts HISTs by branching on edges like a #SAT model counter, in the breadth first order of the ZDD builder.
+// The undecided edges are split into parts that can be counted separately: blocks of the graph with the chosen
+// tree components contracted, joined whenever a vertex that can still end up with tree degree 2 has undecided
+// edges in several of them. Parts without such vertices are counted by the Matrix-Tree theorem, the others are
+// cached by their undecided edges and the tree degrees and components of their vertices.
+// Hidden vertices of the graph and their edges are left out.
+BigNat count_hists_components_alg(AdjListGraph *graph);
+bool count_hists_components(Graph *graph, BigNat *count);
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef HIST_EXISTS_H
+#define HIST_EXISTS_H
+
+#include <histg_lib.h>
+#include <adjlist.h>
+
+// Edge swaps per vertex the constructive step spends on removing degree 2 vertices
+#define EXISTS_MOVES_PER_VERTEX 2
+// Failed branches allowed in the first exhaustive run, every restart doubles it
+#define EXISTS_FIRST_FAILURE_LIMIT 256
+
+// Decides whether the graph without the hidden vertices has a HIST, with the same answer as find_hists_alg
+// with find_one. A spanning tree grown breadth first from a vertex of highest degree is repaired by edge swaps
+// that take degree 2 vertices to degree 1 or 3, which settles most graphs that have a HIST right away.
+// Otherwise the search runs with nogoods and restarts on a random relabelling with a doubled failure limit
+// whenever it exceeds the current one. Relabelling only changes how the branching breaks ties.
+bool hist_exists(Graph *graph, uint64_t hidden_vertices, const HistBranching *branching, Output *output, RunData *run_data);
+// Same as is_hypohist, every search uses hist_exists
+bool is_hypohist_exists(Graph *graph, const HistBranching *branching, Output *output, bool only_partials, RunData *run_data);
+
+#endif
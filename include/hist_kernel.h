@@ -0,0 +1,36 @@
+#ifndef HIST_KERNEL_H
+#define HIST_KERNEL_H
+
+#include <histg_lib.h>
+#include <adjlist.h>
+
+// Leaves kept at a vertex by the twin rule, three already keep it off tree degree 2 whatever else it gets
+#define KERNEL_KEPT_LEAVES 3
+
+// Smaller graph with the same HISTs up to forced edges, found by applying these rules until nothing changes:
+// - a vertex of graph degree 1 or 2 is a leaf in every HIST, so an edge between two of them is in none
+//   unless it is the whole graph and can be removed
+// - pendant vertices at the same vertex are twins whose edges are all forced, all but KERNEL_KEPT_LEAVES
+//   of them are removed and their edges recorded as forced
+typedef struct HistKernel
+{
+    // Reduced graph the search runs on, NULL when the rules show there is no HIST
+    Graph *graph;
+    // Original label of every vertex of the reduced graph
+    unsigned int labels[64];
+    // Edges in every HIST whose leaf was removed, in original labels
+    Edge forced_edges[64];
+    unsigned int nb_forced_edges;
+} HistKernel;
+
+// Hidden vertices are left out of the kernel and of the trees it maps back
+HistKernel *kernel_new(Graph *graph, uint64_t hidden_vertices);
+void free_kernel(HistKernel *kernel);
+// Maps a HIST of the reduced graph to the HIST of the original graph it stands for
+void kernel_expand_tree(HistKernel *kernel, Graph *kernel_tree, Graph *tree);
+
+// Same as find_hists_alg and is_hypohist_alg, but every search runs on the kernel of its graph
+bool find_hists_kernel(Graph *input_graph, uint64_t hidden_vertices, const HistBranching *branching, Output *output, bool find_one, RunData *run_data);
+bool is_hypohist_kernel(Graph *input_graph, const HistBranching *branching, Output *output, bool only_partials, RunData *run_data);
+
+#endif
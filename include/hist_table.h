@@ -0,0 +1,34 @@
+#ifndef HIST_TABLE_H
+#define HIST_TABLE_H
+
+#include <histg_lib.h>
+#include <bignat.h>
+
+// Largest order with a table, K9 has 56961 labeled HISTs among its 9^7 labeled trees
+#define TABLE_MAX_VERTICES 9
+// Masks tested together by the widest SIMD path, tables are padded to a multiple of it
+#define TABLE_LANES 8
+
+// Every labeled HIST on a number of vertices, stored as a bitset over the edges of the complete graph.
+// Edge (i, j) with i < j is bit j(j - 1)/2 + i, the upper triangle order of graph6.
+typedef struct HistTable
+{
+    unsigned int vertices;
+    uint64_t *masks;
+    unsigned int nb_masks;
+    // Padding masks have every high bit set, so no graph contains them
+    unsigned int nb_padded_masks;
+} HistTable;
+
+// Table for the given order, built from the Pruefer sequences of all labeled trees on first use and kept
+// until the program ends. A vertex has tree degree 1 plus its number of occurrences in the sequence,
+// so the HISTs are the sequences in which no vertex occurs exactly once.
+HistTable *hist_table(unsigned int vertices);
+// Edges of the graph as a bitset in table order
+uint64_t table_edge_mask(Graph *graph);
+
+// Counts HISTs by testing every mask of the table against the edges of the graph, without any search.
+// Uses AVX-512 or AVX2 when the processor has them. Returns false for graphs with more than TABLE_MAX_VERTICES vertices.
+bool count_hists_table(Graph *graph, BigNat *count);
+
+#endif
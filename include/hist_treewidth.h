@@ -0,0 +1,26 @@
+#ifndef HIST_TREEWIDTH_H
+#define HIST_TREEWIDTH_H
+
+#include <histg_lib.h>
+#include <bignat.h>
+#include <sparse_laplacian.h>
+
+// Largest bag of the tree decomposition, every bag vertex takes 4 bits of the connectivity label
+#define TD_MAX_BAG 16
+// Largest bag count_hists_td accepts. A bag of k vertices can hold up to Bell(k) 4^k states, with 9 the
+// tables of a 7x7 grid already overflow after seconds of work, which the ZDD and search engines avoid.
+#define TD_MAX_GRAPH_BAG 8
+// Largest number of states a single bag may hold before the engine gives up
+#define TD_MAX_STATES (1 << 20)
+
+// Counts HISTs by dynamic programming over a tree decomposition from a minimum fill elimination order.
+// A state assigns every bag vertex the component of the partial forest it belongs to and its tree degree
+// capped at 3, so the running time is exponential in the treewidth only. Parallel edges are distinct edges.
+// Residues are computed for every prime. Returns false if a table gets too large, or before any table is built
+// if the elimination order has a bag of more than max_bag vertices, which may be at most TD_MAX_BAG.
+bool count_hists_td_mod(EdgeList *edge_list, const uint64_t *primes, int nb_primes, uint64_t *residues, int max_bag);
+
+// Exact number of HISTs, all primes are combined by CRT. Returns false if a bag has more than TD_MAX_GRAPH_BAG vertices.
+bool count_hists_td(Graph *graph, BigNat *count);
+
+#endif
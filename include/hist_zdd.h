@@ -0,0 +1,66 @@
+#ifndef HIST_ZDD_H
+#define HIST_ZDD_H
+
+#include <histg_lib.h>
+#include <adjlist.h>
+#include <bignat.h>
+
+// Largest number of nodes the builder creates before giving up
+#define ZDD_MAX_NODES (1 << 22)
+
+// Terminal nodes, every other node has an index of at least 2
+#define ZDD_EMPTY 0
+#define ZDD_UNIT 1
+
+typedef struct ZddNode
+{
+    // Index of the edge this node decides on, edges between a node and its children are not in the tree
+    int edge;
+    // Child without the edge and child with the edge
+    int lo;
+    int hi;
+} ZddNode;
+
+// Reduced zero-suppressed decision diagram holding every HIST of a graph as its set of edges.
+// Children are stored before their parents, so the nodes are in bottom-up order.
+typedef struct HistZdd
+{
+    unsigned int vertices;
+    int nb_edges;
+    // Edges in the order they are decided on
+    Edge *edges;
+    ZddNode *nodes;
+    int nb_nodes;
+    int root;
+    // Number of HISTs below every node
+    BigNat *counts;
+} HistZdd;
+
+// Frontier based construction: the edges are ordered by a breadth first search, and every node is
+// identified by the component and capped tree degree of the vertices that have both decided and
+// undecided edges. Hidden vertices of the graph and their edges are left out.
+// Returns NULL if the diagram would exceed ZDD_MAX_NODES nodes.
+HistZdd *zdd_build(AdjListGraph *graph);
+// Edges of the available vertices in the order the builder decides on them, by a breadth first search from the
+// first vertex. Edges must hold every edge of the graph, returns the number of edges or -1 if the vertices are
+// not connected.
+int zdd_edge_order(AdjListGraph *graph, Edge *edges);
+HistZdd *zdd_from_graph(Graph *graph);
+void free_zdd(HistZdd *zdd);
+
+BigNat zdd_count(HistZdd *zdd);
+// Number of HISTs containing each edge, indexed like zdd->edges
+void zdd_edge_counts(HistZdd *zdd, BigNat *counts);
+
+// HISTs are ranked in the order of the diagram: at every node the HISTs without its edge come first.
+// The rank must be below the number of HISTs.
+void zdd_unrank(HistZdd *zdd, BigNat *rank, Graph *tree);
+// Returns false if the tree is not one of the HISTs
+bool zdd_rank(HistZdd *zdd, Graph *tree, BigNat *rank);
+// Uniformly random HIST, the diagram must not be empty. The seed is advanced.
+void zdd_sample(HistZdd *zdd, uint64_t *seed, Graph *tree);
+
+// Counts HISTs by building the diagram, returns false if it gets too large
+bool count_hists_zdd(Graph *graph, BigNat *count);
+
+#endif
@@ -21,6 +21,10 @@ typedef struct Graph
 
 Graph *empty_graph(unsigned int vertices);
 void graph_copy(const Graph *original, Graph *copy);
+// Copy of the graph without the given vertex, the vertices after it move down by one
+Graph *graph_without_vertex(const Graph *original, unsigned int vertex);
+// Copy of the graph where vertex v becomes vertex map[v], map must be a permutation
+Graph *graph_map_vertices(const Graph *original, const unsigned int *map);
 
 void free_graph(Graph *graph);
 
@@ -39,6 +43,8 @@ typedef struct Output
 {
     FILE *output_file;
     Format format;
+    // Original label of every vertex of the printed graphs, NULL when they are printed as they are
+    const unsigned int *labels;
 } Output;
 
 typedef struct RunData
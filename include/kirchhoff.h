@@ -2,6 +2,7 @@
 #define KIRCHOFF_H
 
 #include <histg_lib.h>
+#include <bignat.h>
 
 typedef struct IMatrix
 {
@@ -25,4 +26,25 @@ void bareiss(IMatrix *matrix);
 
 long long int kirchhoff(Graph *graph);
 
+// Determinant modulo a prime, by Gaussian elimination with row pivoting
+uint64_t determinant_mod(IMatrix *matrix, uint64_t p);
+// Same on an n by n array of residues stored row by row, which is overwritten
+uint64_t determinant_mod_in_place(uint64_t *data, int n, uint64_t p);
+// Gauss-Jordan elimination modulo a prime with row pivoting, returns the determinant.
+// When the determinant is not zero the inverse is written to inverse, row by row.
+uint64_t inverse_mod(IMatrix *matrix, uint64_t p, uint64_t *inverse);
+// Number of spanning trees modulo a prime
+uint64_t kirchhoff_mod(Graph *graph, uint64_t p);
+// Number of bits that suffices to hold the number of spanning trees of the graph
+int spanning_tree_bits(Graph *graph);
+// Combines residues modulo distinct primes into the unique number below their product
+BigNat bignat_from_residues(uint64_t *residues, const uint64_t *primes, int nb_primes);
+// Exact number of spanning trees, from determinants modulo several primes combined by CRT
+BigNat kirchhoff_exact(Graph *graph);
+
+// Exact number of spanning trees of G - e for every edge, ordered by origin and then destination,
+// and of G - v for every vertex, all from a single inverse of the reduced Laplacian per prime.
+// Takes O(n^3 + m + sum deg(v)^3) per prime, which is O(n^4) for dense graphs.
+void kirchhoff_deletions(Graph *graph, BigNat *edge_counts, BigNat *vertex_counts);
+
 #endif
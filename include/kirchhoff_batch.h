@@ -0,0 +1,34 @@
+#ifndef KIRCHHOFF_BATCH_H
+#define KIRCHHOFF_BATCH_H
+
+#include <histg_lib.h>
+#include <bignat.h>
+
+// Number of graphs whose Laplacians are eliminated together, one per SIMD lane
+#define KIRCHHOFF_BATCH_SIZE 8
+
+// Reduced Laplacians of a batch of graphs with the same number of vertices.
+// Element (row, column) of the graph in lane l is stored at data[(row * size + column) * KIRCHHOFF_BATCH_SIZE + l].
+typedef struct LaplacianBatch
+{
+    uint64_t *data;
+    // Number of rows and columns of every reduced Laplacian
+    int size;
+    // Largest size the data array has room for
+    int max_size;
+    int nb_graphs;
+} LaplacianBatch;
+
+LaplacianBatch *lb_new(int max_vertices);
+void free_lb(LaplacianBatch *batch);
+
+// Determinants modulo a prime below 2^31 of the first nb_graphs lanes, whose data holds residues in [0, p).
+// Each determinant is numerators[lane] / denominators[lane], so callers can postpone the inversion.
+// The data is overwritten. The elimination does not pivot, lanes with a zero pivot before the last row
+// are flagged in zero_pivots and have to be recomputed by the caller.
+void lb_determinants_mod(LaplacianBatch *batch, uint64_t p, uint64_t *numerators, uint64_t *denominators, bool *zero_pivots);
+
+// Exact number of spanning trees for up to KIRCHHOFF_BATCH_SIZE graphs with the same number of vertices
+void kirchhoff_exact_batch(LaplacianBatch *batch, Graph **graphs, int nb_graphs, BigNat *results);
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef MODULAR_H
+#define MODULAR_H
+
+#include <stdint.h>
+
+// Primes just below 2^62, so the sum of two residues never overflows
+#define NB_MODULAR_PRIMES 8
+extern const uint64_t MODULAR_PRIMES[NB_MODULAR_PRIMES];
+
+// Primes just below 2^31, products of two residues fit in 64 bits.
+// Used where residues are packed in SIMD lanes.
+#define NB_MODULAR_PRIMES_31 16
+extern const uint64_t MODULAR_PRIMES_31[NB_MODULAR_PRIMES_31];
+
+uint64_t mod_add(uint64_t a, uint64_t b, uint64_t p);
+uint64_t mod_sub(uint64_t a, uint64_t b, uint64_t p);
+uint64_t mod_mul(uint64_t a, uint64_t b, uint64_t p);
+uint64_t mod_pow(uint64_t base, uint64_t exponent, uint64_t p);
+// Inverse of a non-zero residue modulo a prime
+uint64_t mod_inverse(uint64_t a, uint64_t p);
+// Residue of a signed value
+uint64_t mod_from_signed(long long int value, uint64_t p);
+
+#endif
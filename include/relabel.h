@@ -0,0 +1,26 @@
+#ifndef RELABEL_H
+#define RELABEL_H
+
+#include <histg_lib.h>
+
+// Vertex orders the searches can run in, they branch on low labels first
+typedef enum Relabeling
+{
+    // Labels as read
+    RelabelNone,
+    // Reverse of the smallest-last order, so the densest core comes first
+    RelabelDegeneracy,
+    // Highest degree vertex first, then always the highest degree neighbour of the labeled vertices, as winter does
+    RelabelBfs,
+    // Breadth first from a lowest degree vertex, visiting neighbours by increasing degree
+    RelabelCuthillMcKee,
+} Relabeling;
+
+// Parses none, degeneracy, bfs or cuthill-mckee, returns false for anything else
+bool relabeling_from_name(const char *name, Relabeling *relabeling);
+// Fills labels so that labels[new] is the original label of vertex new in the given order
+void relabel_order(const Graph *graph, Relabeling relabeling, unsigned int *labels);
+// Copy of the graph where vertex new is the original vertex labels[new]
+Graph *relabel_graph(const Graph *graph, const unsigned int *labels);
+
+#endif
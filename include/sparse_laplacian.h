@@ -0,0 +1,85 @@
+#ifndef SPARSE_LAPLACIAN_H
+#define SPARSE_LAPLACIAN_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Graph of arbitrary size given by its edges, parallel edges are allowed and self loops are ignored
+typedef struct EdgeList
+{
+    int vertices;
+    int edges;
+    int *origins;
+    int *destinations;
+} EdgeList;
+
+// Reads one graph: a line with the number of vertices and edges, followed by one line 'u v' per edge.
+// Vertices are numbered from 0. Returns false when the input is exhausted.
+bool parse_edge_list(FILE *input, EdgeList *edge_list);
+void free_edge_list(EdgeList *edge_list);
+
+bool edge_list_is_connected(EdgeList *edge_list);
+
+typedef struct SparseEntry
+{
+    int column;
+    double value;
+    uint64_t residue;
+} SparseEntry;
+
+typedef struct SparseRow
+{
+    SparseEntry *entries;
+    int size;
+    int capacity;
+} SparseRow;
+
+// Reduced Laplacian with both floating point values and residues modulo p.
+// The ground vertex has no row, entries pointing to it are left out.
+typedef struct SparseLaplacian
+{
+    int vertices;
+    int ground;
+    uint64_t p;
+    SparseRow *rows;
+    double *diagonal;
+    uint64_t *diagonal_residues;
+} SparseLaplacian;
+
+SparseLaplacian *sparse_laplacian(EdgeList *edge_list, uint64_t p);
+void free_sparse_laplacian(SparseLaplacian *laplacian);
+
+typedef struct SparseTreeCount
+{
+    // Natural logarithm of the number of spanning trees, -inf for disconnected graphs
+    double log_tau;
+    // Number of spanning trees modulo p, only set when tau_mod_known
+    uint64_t tau_mod;
+    // False when a pivot before the last one vanished modulo p, which the minimum degree order can't avoid
+    bool tau_mod_known;
+} SparseTreeCount;
+
+/*
+ * Binary min heap on vertex degrees. Stale entries are skipped by the caller when popped,
+ * so a vertex is pushed again whenever its degree changes.
+ */
+typedef struct DegreeHeap
+{
+    int *degrees;
+    int *vertices;
+    int size;
+    int capacity;
+} DegreeHeap;
+
+void dh_push(DegreeHeap *heap, int degree, int vertex);
+// The heap must not be empty
+void dh_pop(DegreeHeap *heap, int *degree, int *vertex);
+
+// LDL^T factorization of the reduced Laplacian in minimum degree order, the pivots are the entries of D.
+// The laplacian is consumed by the elimination. A pivot that vanishes modulo p only gives up the residue.
+SparseTreeCount sparse_ldlt(SparseLaplacian *laplacian);
+
+SparseTreeCount sparse_kirchhoff(EdgeList *edge_list, uint64_t p);
+
+#endif
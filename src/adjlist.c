@@ -1,5 +1,7 @@
 #include <adjlist.h>
 #include <stdlib.h>
+#include <string.h>
+#include <limits.h>
 
 /*
  * Adjacency List Edge
@@ -35,6 +37,18 @@ AdjListEdgeArray *alea_new()
     return alea_with_capacity(4);
 }
 
+// Edge array stored in the given arena, the capacity can't grow afterwards
+AdjListEdgeArray *alea_in_arena(Arena *arena, unsigned int capacity)
+{
+    AdjListEdgeArray *alea = arena_alloc(arena, sizeof(AdjListEdgeArray));
+
+    alea->size = 0;
+    alea->capacity = capacity;
+    alea->edges = arena_alloc(arena, capacity * sizeof(AdjListEdge));
+
+    return alea;
+}
+
 AdjListEdge *add_edge_alea(AdjListEdgeArray *alea, AdjListEdge edge)
 {
     if (alea->capacity <= alea->size)
@@ -97,16 +111,16 @@ AdjListNeighbourArray alna_new()
     return alna_with_capacity(4);
 }
 
-AdjListNeighbourArray *alna_array(unsigned int count)
+// Neighbour array stored in the given arena, the capacity can't grow afterwards
+AdjListNeighbourArray alna_in_arena(Arena *arena, unsigned int capacity)
 {
-    AdjListNeighbourArray *array = malloc(count * sizeof(AdjListNeighbourArray));
+    AdjListNeighbourArray alna;
 
-    for (int i = 0; i < count; i++)
-    {
-        array[i] = alna_new();
-    }
+    alna.size = 0;
+    alna.capacity = capacity;
+    alna.neighbours = arena_alloc(arena, capacity * sizeof(AdjListNeighbour));
 
-    return array;
+    return alna;
 }
 
 void add_neighbour_alna(AdjListNeighbourArray *alna, AdjListNeighbour neighbour)
@@ -148,44 +162,86 @@ void add_neighbour_for_vertex_alna(AdjListNeighbourArray *alna, unsigned int ver
 /*
  * Adjacency List Graph
  */
-AdjListGraph *alg_from_graph_and_hidden(Graph *graph, uint64_t hidden_vertices)
+// Smallest tree degree a vertex can end up with in a HIST, given its current tree degree
+unsigned int min_hist_degree(unsigned int tree_degree)
 {
-    AdjListGraph *alg = malloc(sizeof(AdjListGraph));
+    return tree_degree < 2 ? 1 : tree_degree == 2 ? 3 : tree_degree;
+}
+
+// Largest tree degree a vertex can end up with in a HIST, given its current graph degree
+unsigned int max_hist_degree(unsigned int graph_degree)
+{
+    return graph_degree == 2 ? 1 : graph_degree;
+}
+
+// Number of arena bytes needed to store the AdjListGraph for the given graph
+size_t alg_storage_size(Graph *graph)
+{
+    unsigned int vertices = graph->vertices;
+    unsigned int degree_sum = 0;
+    size_t size = 0;
+
+    for (unsigned int vertex = 0; vertex < vertices; vertex++)
+    {
+        unsigned int degree = vertex_degree(graph->adjacency_matrix[vertex]);
+        size += arena_aligned_size(degree * sizeof(AdjListNeighbour));
+        degree_sum += degree;
+    }
+
+    size += arena_aligned_size(sizeof(AdjListEdgeArray));
+    size += arena_aligned_size(degree_sum / 2 * sizeof(AdjListEdge));
+    size += arena_aligned_size(vertices * sizeof(AdjListNeighbourArray));
+    size += 2 * arena_aligned_size(vertices * sizeof(unsigned int));
+    size += arena_aligned_size(vertices * sizeof(uint64_t));
+
+    return size;
+}
 
+// Fills alg with the graph, taking all storage from the arena.
+// The arena must have room for alg_storage_size bytes, all arrays are allocated
+// with their exact final size so they never need to grow.
+// Edges incident to hidden vertices are stored as removed so the vertices can be unhidden later.
+void alg_fill(AdjListGraph *alg, Arena *arena, Graph *graph, uint64_t hidden_vertices)
+{
     HideData hd = construct_hide_data(hidden_vertices, graph->vertices);
 
     // Initialize values
     alg->vertices = graph->vertices;
     alg->available_vertices = hd.available_vertices;
     alg->nb_available_vertices = graph->vertices - hd.nb_hidden_vertices;
-    alg->edges = alea_with_capacity(graph->edges);
-    alg->neighbours = alna_array(graph->vertices);
+    alg->neighbours = arena_alloc(arena, alg->vertices * sizeof(AdjListNeighbourArray));
     alg->d_nb_tree_edges = 0;
-    alg->d_graph_degrees = calloc(alg->vertices, sizeof(unsigned int));
-    alg->d_tree_degrees = calloc(alg->vertices, sizeof(unsigned int));
+    alg->d_nb_graph_edges = 0;
+    alg->d_graph_degrees = arena_calloc(arena, alg->vertices, sizeof(unsigned int));
+    alg->d_tree_degrees = arena_calloc(arena, alg->vertices, sizeof(unsigned int));
+    alg->d_graph_adjacencies = arena_alloc(arena, alg->vertices * sizeof(uint64_t));
     alg->extendable_vertices = 0;
+    alg->d_min_degree_sum = alg->nb_available_vertices;
+    alg->d_max_degree_sum = 0;
 
     // Calculate degrees for all vertices
+    unsigned int degree_sum = 0;
     for (int vertex = 0; vertex < graph->vertices; vertex++)
     {
         uint64_t vertex_bit = FIRST_BIT >> vertex;
         bool available = vertex_bit & hd.available_vertices;
 
-        uint64_t available_neighbours = available ? graph->adjacency_matrix[vertex] & hd.available_vertices : 0;
-        unsigned int degree = vertex_degree(available_neighbours);
+        uint64_t adjacencies = graph->adjacency_matrix[vertex];
+        uint64_t available_neighbours = available ? adjacencies & hd.available_vertices : 0;
 
-        alg->d_graph_degrees[vertex] = degree;
+        alg->d_graph_degrees[vertex] = vertex_degree(available_neighbours);
+        alg->d_graph_adjacencies[vertex] = available_neighbours;
+        alg->d_max_degree_sum += max_hist_degree(alg->d_graph_degrees[vertex]);
+        alg->neighbours[vertex] = alna_in_arena(arena, vertex_degree(adjacencies));
+        degree_sum += vertex_degree(adjacencies);
     }
 
+    alg->edges = alea_in_arena(arena, degree_sum / 2);
+
     // Determine and store all edges & neighbours
-    for (unsigned int origin = 0; origin < alg->vertices - 1; origin++)
+    for (unsigned int origin = 0; origin + 1 < alg->vertices; origin++)
     {
-        uint64_t origin_bit = FIRST_BIT >> origin;
-
-        if (!(origin_bit & hd.available_vertices))
-            continue;
-
-        uint64_t origin_adjacencies = graph->adjacency_matrix[origin] & hd.available_vertices;
+        uint64_t origin_adjacencies = graph->adjacency_matrix[origin];
 
         for (unsigned int destination = origin + 1; destination < alg->vertices; destination++)
         {
@@ -193,7 +249,11 @@ AdjListGraph *alg_from_graph_and_hidden(Graph *graph, uint64_t hidden_vertices)
 
             if (destination_bit & origin_adjacencies)
             {
+                uint64_t endpoints = (FIRST_BIT >> origin) | destination_bit;
+
                 AdjListEdge edge = ale_new(origin, destination);
+                edge.removed = (endpoints & hd.available_vertices) != endpoints;
+                alg->d_nb_graph_edges += !edge.removed;
                 AdjListEdge *edge_ptr = add_edge_alea(alg->edges, edge);
 
                 AdjListNeighbour origins_neighbour = aln_new(destination, edge_ptr);
@@ -204,22 +264,79 @@ AdjListGraph *alg_from_graph_and_hidden(Graph *graph, uint64_t hidden_vertices)
             }
         }
     }
+}
+
+AdjListGraph *alg_from_graph_and_hidden(Graph *graph, uint64_t hidden_vertices)
+{
+    AdjListGraph *alg = malloc(sizeof(AdjListGraph));
+    Arena *arena = malloc(sizeof(Arena));
+
+    if (alg == NULL || arena == NULL)
+    {
+        fprintf(stderr, "Failed to allocate AdjListGraph\n");
+        exit(EXIT_FAILURE);
+    }
+
+    *arena = arena_new();
+    arena_reserve(arena, alg_storage_size(graph));
+    alg_fill(alg, arena, graph, hidden_vertices);
+    alg->arena = arena;
 
     return alg;
 }
 
 void free_alg(AdjListGraph *graph)
 {
-    free_alna(graph->neighbours, graph->vertices);
-    free_alea(graph->edges);
-    free(graph->d_graph_degrees);
-    free(graph->d_tree_degrees);
+    if (graph->arena)
+    {
+        free_arena(graph->arena);
+        free(graph->arena);
+    }
+
     free(graph);
 }
 
-Graph *get_tree(AdjListGraph *alg)
+/*
+ * Adjacency List Workspace
+ */
+AdjListWorkspace *alw_new()
 {
-    Graph *graph = empty_graph(alg->vertices);
+    AdjListWorkspace *workspace = malloc(sizeof(AdjListWorkspace));
+
+    if (workspace == NULL)
+    {
+        fprintf(stderr, "Failed to allocate AdjListWorkspace\n");
+        exit(EXIT_FAILURE);
+    }
+
+    workspace->arena = arena_new();
+
+    return workspace;
+}
+
+void free_alw(AdjListWorkspace *workspace)
+{
+    free_arena(&workspace->arena);
+    free(workspace);
+}
+
+AdjListGraph *alg_from_graph_and_hidden_ws(AdjListWorkspace *workspace, Graph *graph, uint64_t hidden_vertices)
+{
+    arena_reset(&workspace->arena);
+    arena_reserve(&workspace->arena, alg_storage_size(graph));
+
+    AdjListGraph *alg = &workspace->graph;
+    alg_fill(alg, &workspace->arena, graph, hidden_vertices);
+    alg->arena = NULL;
+
+    return alg;
+}
+
+// Overwrites tree with the currently selected edges
+void fill_tree(AdjListGraph *alg, Graph *tree)
+{
+    memset(tree->adjacency_matrix, 0, tree->vertices * sizeof(uint64_t));
+    tree->edges = 0;
 
     AdjListEdgeArray *edge_array = alg->edges;
 
@@ -232,13 +349,88 @@ Graph *get_tree(AdjListGraph *alg)
             edge.origin = alg_edge.origin;
             edge.destination = alg_edge.destination;
 
-            add_edge_to_graph(graph, &edge);
+            add_edge_to_graph(tree, &edge);
         }
     }
+}
 
+Graph *get_tree(AdjListGraph *alg)
+{
+    Graph *graph = empty_graph(alg->vertices);
+    fill_tree(alg, graph);
     return graph;
 }
 
+/*
+ * Hiding vertices
+ * Only allowed while no search is in progress: no edges are selected and
+ * the only removed edges are the ones incident to hidden vertices.
+ */
+void alg_hide_vertex(AdjListGraph *graph, unsigned int vertex)
+{
+    uint64_t vertex_bit = FIRST_BIT >> vertex;
+
+    if (!(vertex_bit & graph->available_vertices))
+        return;
+
+    AdjListNeighbourArray n_array = graph->neighbours[vertex];
+
+    for (int i = 0; i < n_array.size; i++)
+    {
+        AdjListNeighbour neighbour = n_array.neighbours[i];
+
+        if (neighbour.edge->removed)
+            continue;
+
+        neighbour.edge->removed = true;
+        graph->d_nb_graph_edges -= 1;
+        graph->d_max_degree_sum -= max_hist_degree(graph->d_graph_degrees[neighbour.vertex]);
+        graph->d_graph_degrees[neighbour.vertex] -= 1;
+        graph->d_max_degree_sum += max_hist_degree(graph->d_graph_degrees[neighbour.vertex]);
+        graph->d_graph_adjacencies[neighbour.vertex] &= ~vertex_bit;
+    }
+
+    graph->d_max_degree_sum -= max_hist_degree(graph->d_graph_degrees[vertex]);
+    graph->d_min_degree_sum -= 1;
+    graph->d_graph_degrees[vertex] = 0;
+    graph->d_graph_adjacencies[vertex] = 0;
+    graph->available_vertices &= ~vertex_bit;
+    graph->nb_available_vertices -= 1;
+}
+
+void alg_unhide_vertex(AdjListGraph *graph, unsigned int vertex)
+{
+    uint64_t vertex_bit = FIRST_BIT >> vertex;
+
+    if (vertex_bit & graph->available_vertices)
+        return;
+
+    AdjListNeighbourArray n_array = graph->neighbours[vertex];
+
+    for (int i = 0; i < n_array.size; i++)
+    {
+        AdjListNeighbour neighbour = n_array.neighbours[i];
+
+        if (!((FIRST_BIT >> neighbour.vertex) & graph->available_vertices))
+            continue;
+
+        neighbour.edge->removed = false;
+        graph->d_nb_graph_edges += 1;
+        graph->d_max_degree_sum -= max_hist_degree(graph->d_graph_degrees[neighbour.vertex]);
+        graph->d_graph_degrees[neighbour.vertex] += 1;
+        graph->d_max_degree_sum += max_hist_degree(graph->d_graph_degrees[neighbour.vertex]);
+        graph->d_graph_degrees[vertex] += 1;
+        graph->d_graph_adjacencies[neighbour.vertex] |= vertex_bit;
+        graph->d_graph_adjacencies[vertex] |= FIRST_BIT >> neighbour.vertex;
+    }
+
+    graph->d_max_degree_sum += max_hist_degree(graph->d_graph_degrees[vertex]);
+    graph->d_min_degree_sum += 1;
+
+    graph->available_vertices |= vertex_bit;
+    graph->nb_available_vertices += 1;
+}
+
 /*
  * Adjacency List hist algorithm
  */
@@ -273,8 +465,13 @@ void update_extendable_vertices_alg(AdjListGraph *graph, AdjListEdge *edge)
 void add_edge_to_graph_alg(AdjListGraph *graph, AdjListEdge *edge)
 {
     edge->removed = false;
+    graph->d_nb_graph_edges += 1;
+    graph->d_max_degree_sum -= max_hist_degree(graph->d_graph_degrees[edge->origin]) + max_hist_degree(graph->d_graph_degrees[edge->destination]);
     graph->d_graph_degrees[edge->origin] += 1;
     graph->d_graph_degrees[edge->destination] += 1;
+    graph->d_max_degree_sum += max_hist_degree(graph->d_graph_degrees[edge->origin]) + max_hist_degree(graph->d_graph_degrees[edge->destination]);
+    graph->d_graph_adjacencies[edge->origin] |= FIRST_BIT >> edge->destination;
+    graph->d_graph_adjacencies[edge->destination] |= FIRST_BIT >> edge->origin;
     update_extendable_vertices_alg(graph, edge);
 }
 
@@ -282,16 +479,23 @@ void add_edge_to_tree_alg(AdjListGraph *graph, AdjListEdge *edge)
 {
     edge->selected = true;
     graph->d_nb_tree_edges += 1;
+    graph->d_min_degree_sum -= min_hist_degree(graph->d_tree_degrees[edge->origin]) + min_hist_degree(graph->d_tree_degrees[edge->destination]);
     graph->d_tree_degrees[edge->origin] += 1;
     graph->d_tree_degrees[edge->destination] += 1;
+    graph->d_min_degree_sum += min_hist_degree(graph->d_tree_degrees[edge->origin]) + min_hist_degree(graph->d_tree_degrees[edge->destination]);
     update_extendable_vertices_alg(graph, edge);
 }
 
 void remove_edge_from_graph_alg(AdjListGraph *graph, AdjListEdge *edge)
 {
     edge->removed = true;
+    graph->d_nb_graph_edges -= 1;
+    graph->d_max_degree_sum -= max_hist_degree(graph->d_graph_degrees[edge->origin]) + max_hist_degree(graph->d_graph_degrees[edge->destination]);
     graph->d_graph_degrees[edge->origin] -= 1;
     graph->d_graph_degrees[edge->destination] -= 1;
+    graph->d_max_degree_sum += max_hist_degree(graph->d_graph_degrees[edge->origin]) + max_hist_degree(graph->d_graph_degrees[edge->destination]);
+    graph->d_graph_adjacencies[edge->origin] &= ~(FIRST_BIT >> edge->destination);
+    graph->d_graph_adjacencies[edge->destination] &= ~(FIRST_BIT >> edge->origin);
     update_extendable_vertices_alg(graph, edge);
 }
 
@@ -299,8 +503,10 @@ void remove_edge_from_tree_alg(AdjListGraph *graph, AdjListEdge *edge)
 {
     edge->selected = false;
     graph->d_nb_tree_edges -= 1;
+    graph->d_min_degree_sum -= min_hist_degree(graph->d_tree_degrees[edge->origin]) + min_hist_degree(graph->d_tree_degrees[edge->destination]);
     graph->d_tree_degrees[edge->origin] -= 1;
     graph->d_tree_degrees[edge->destination] -= 1;
+    graph->d_min_degree_sum += min_hist_degree(graph->d_tree_degrees[edge->origin]) + min_hist_degree(graph->d_tree_degrees[edge->destination]);
     update_extendable_vertices_alg(graph, edge);
 }
 
@@ -414,101 +620,1317 @@ bool hist_impossible(AdjListGraph *graph, AdjListEdge *edge)
     bool orig_two_guaranteed = graph_d[orig] == 2 && tree_d[orig] == 2;
     bool dest_two_guaranteed = graph_d[dest] == 2 && tree_d[dest] == 2;
 
-    return zero_degree || orig_two_guaranteed || dest_two_guaranteed;
+    // A HIST on n vertices has degree sum 2(n - 1), so it needs more than n / 2 leaves
+    unsigned int degree_sum = 2 * (graph->nb_available_vertices - 1);
+    bool degree_sum_impossible = graph->d_min_degree_sum > degree_sum || graph->d_max_degree_sum < degree_sum;
+
+    return zero_degree || orig_two_guaranteed || dest_two_guaranteed || degree_sum_impossible;
 }
 
-void add_edge_alg(AdjListGraph *graph, AdjListEdge *edge, Output *output, bool find_one, RunData *run_data)
+// Breadth first search from the origin that may not use the edge itself, a level at a time
+bool alg_is_bridge(AdjListGraph *graph, AdjListEdge *edge)
 {
-    add_edge_to_tree_alg(graph, edge);
+    // An edge in a triangle is never a bridge, which settles most edges of dense graphs at once
+    if (graph->d_graph_adjacencies[edge->origin] & graph->d_graph_adjacencies[edge->destination])
+        return false;
 
-    if (hist_impossible(graph, edge))
-        return;
+    uint64_t target = FIRST_BIT >> edge->destination;
+    uint64_t reached = FIRST_BIT >> edge->origin;
+    uint64_t frontier = graph->d_graph_adjacencies[edge->origin] & ~target;
+
+    while (frontier)
+    {
+        if (frontier & target)
+            return false;
+
+        reached |= frontier;
+
+        uint64_t next = 0;
+        for (uint64_t rest = frontier; rest; rest &= rest - 1)
+            next |= graph->d_graph_adjacencies[last_bit_position(rest)];
+
+        frontier = next & ~reached;
+    }
 
-    hists_alg(graph, output, find_one, run_data);
+    return true;
 }
 
-void remove_edge_alg(AdjListGraph *graph, AdjListEdge *edge, Output *output, bool find_one, RunData *run_data)
+// Vertices reachable from the origin without using the edge, the origin's side of the cut if it is a bridge
+uint64_t alg_side_of_edge(AdjListGraph *graph, AdjListEdge *edge)
 {
-    remove_edge_from_graph_alg(graph, edge);
+    uint64_t reached = FIRST_BIT >> edge->origin;
+    uint64_t frontier = graph->d_graph_adjacencies[edge->origin] & ~(FIRST_BIT >> edge->destination);
 
-    if (hist_impossible(graph, edge))
-        return;
+    while (frontier)
+    {
+        reached |= frontier;
+
+        uint64_t next = 0;
+        for (uint64_t rest = frontier; rest; rest &= rest - 1)
+            next |= graph->d_graph_adjacencies[last_bit_position(rest)];
+
+        frontier = next & ~reached;
+    }
+
+    return reached;
+}
+
+/*
+ * Iterative search
+ * Every change the search makes to the graph is pushed on the trail, each decision
+ * remembers where its changes start on the trail so they can be undone together.
+ */
+void hist_iter_init(HistIterator *iterator, AdjListGraph *graph, const HistBranching *branching)
+{
+    // Every edge is changed at most once on any path through the search
+    unsigned int capacity = graph->edges->size + 1;
+
+    iterator->graph = graph;
+    iterator->capacity = capacity;
+    iterator->trail = malloc(capacity * sizeof(AdjListTrailEntry));
+    iterator->decisions = malloc(capacity * sizeof(AdjListDecision));
+
+    if (iterator->trail == NULL || iterator->decisions == NULL)
+    {
+        fprintf(stderr, "Failed to allocate hist iterator\n");
+        exit(EXIT_FAILURE);
+    }
+
+    iterator->trail_size = 0;
+    iterator->nb_decisions = 0;
+    iterator->started = false;
+    iterator->exhausted = false;
+    iterator->trees = 0;
+    iterator->hists = 0;
+    iterator->learning = NULL;
+    iterator->failures = 0;
+    iterator->failure_limit = 0;
+    iterator->interrupted = false;
+    iterator->branching = branching;
+    iterator->endgame.active = false;
+    iterator->weights = malloc((graph->vertices + 1) * sizeof(unsigned int));
+
+    if (iterator->weights == NULL)
+    {
+        fprintf(stderr, "Failed to allocate hist iterator\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (unsigned int v = 0; v < graph->vertices; v++)
+        iterator->weights[v] = 1;
+}
+
+void *learning_alloc(size_t size)
+{
+    void *pointer = malloc(size);
+
+    if (pointer == NULL)
+    {
+        fprintf(stderr, "Failed to allocate conflict analysis\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return pointer;
+}
 
-    hists_alg(graph, output, find_one, run_data);
+void hist_learn_clear(AdjListLearning *learning, unsigned int nb_edges)
+{
+    learning->active = true;
+    learning->nb_reasons = 0;
+    learning->pending_reason = UINT_MAX;
+    learning->conflict_size = 0;
+    learning->nb_nogoods = 0;
+
+    for (unsigned int i = 0; i < 2 * nb_edges; i++)
+        learning->watches[i] = -1;
 }
 
-void hists_alg(AdjListGraph *graph, Output *output, bool find_one, RunData *run_data)
+void hist_iter_learn(HistIterator *iterator)
 {
-    if (find_one && run_data->hists_this_run >= 1)
+    if (iterator->learning)
         return;
 
-    if (tree_is_finished_alg(graph))
+    unsigned int nb_edges = iterator->graph->edges->size;
+    unsigned int capacity = iterator->capacity;
+
+    AdjListLearning *learning = learning_alloc(sizeof(AdjListLearning));
+    learning->words = (capacity + 63) / 64;
+    learning->positions = learning_alloc(nb_edges * sizeof(unsigned int));
+    learning->levels = learning_alloc(capacity * sizeof(unsigned int));
+    learning->reason_starts = learning_alloc(capacity * sizeof(unsigned int));
+    learning->reason_sizes = learning_alloc(capacity * sizeof(unsigned int));
+    learning->reasons_capacity = 4 * capacity;
+    learning->reasons = learning_alloc(learning->reasons_capacity * sizeof(AdjListEdge *));
+    // Large enough for the edges at a vertex together with every edge or every decision
+    learning->conflict = learning_alloc((64 + 2 * capacity) * sizeof(AdjListEdge *));
+    learning->branch_sets = learning_alloc((size_t)capacity * learning->words * sizeof(uint64_t));
+    learning->failure = learning_alloc(learning->words * sizeof(uint64_t));
+    learning->seen = learning_alloc(capacity * sizeof(bool));
+    learning->nogoods = learning_alloc(NOGOOD_SLOTS * sizeof(AdjListNogood));
+    learning->watches = learning_alloc((2 * nb_edges + 1) * sizeof(int));
+    memset(learning->seen, 0, capacity * sizeof(bool));
+
+    hist_learn_clear(learning, nb_edges);
+    iterator->learning = learning;
+}
+
+unsigned int hist_learn_edge_index(HistIterator *iterator, AdjListEdge *edge)
+{
+    return edge - iterator->graph->edges->edges;
+}
+
+// Trail position of the change to the edge, or UINT_MAX if the search didn't change it
+unsigned int hist_learn_position(HistIterator *iterator, AdjListEdge *edge)
+{
+    unsigned int position = iterator->learning->positions[hist_learn_edge_index(iterator, edge)];
+
+    if (position < iterator->trail_size && iterator->trail[position].edge == edge)
+        return position;
+
+    return UINT_MAX;
+}
+
+void hist_iter_push_trail(HistIterator *iterator, AdjListEdge *edge, AdjListTrailOperation operation)
+{
+    unsigned int position = iterator->trail_size++;
+    AdjListTrailEntry *entry = &iterator->trail[position];
+    entry->edge = edge;
+    entry->operation = operation;
+
+    AdjListLearning *learning = iterator->learning;
+    if (learning && learning->active)
+    {
+        learning->positions[hist_learn_edge_index(iterator, edge)] = position;
+        learning->levels[position] = iterator->nb_decisions - 1;
+        learning->reason_starts[position] = learning->pending_reason;
+        learning->reason_sizes[position] = learning->nb_reasons - learning->pending_reason;
+        learning->pending_reason = UINT_MAX;
+    }
+}
+
+void hist_iter_undo_to(HistIterator *iterator, unsigned int trail_size)
+{
+    AdjListGraph *graph = iterator->graph;
+    AdjListLearning *learning = iterator->learning;
+
+    // Reasons are stored in trail order, so they are dropped together with the oldest change undone
+    if (learning && learning->active)
     {
-        if (is_valid_hist_alg(graph))
+        for (unsigned int position = trail_size; position < iterator->trail_size; position++)
         {
-            if (output)
+            if (learning->reason_starts[position] != UINT_MAX)
             {
-                Graph *tree = get_tree(graph);
-                print_graph_to_output(output, tree);
-                free_graph(tree);
+                learning->nb_reasons = learning->reason_starts[position];
+                break;
             }
-
-            run_data->hists_this_run += 1;
         }
+    }
 
-        run_data->trees_this_run += 1;
+    while (iterator->trail_size > trail_size)
+    {
+        AdjListTrailEntry entry = iterator->trail[--iterator->trail_size];
 
-        return;
+        if (entry.operation == TrailTreeAdd)
+            remove_edge_from_tree_alg(graph, entry.edge);
+        else
+            add_edge_to_graph_alg(graph, entry.edge);
     }
+}
 
-    AdjListEdge *edge;
-    bool both_in_tree = false;
-    if (get_next_edge_alg(graph, &edge, &both_in_tree))
+/*
+ * Branching strategies
+ * Every strategy scores the possible origins and the undecided edges at the chosen origin,
+ * the lowest score wins and ties go to the vertex or edge seen first.
+ */
+typedef unsigned int (*HistBranchScore)(HistIterator *iterator, unsigned int vertex);
+
+bool hist_branch_by_scores(HistIterator *iterator, HistBranchScore origin_score, HistBranchScore destination_score, AdjListEdge **out_edge, bool *out_both_in_tree)
+{
+    AdjListGraph *graph = iterator->graph;
+    uint64_t origins = graph->d_nb_tree_edges == 0 ? graph->available_vertices : graph->extendable_vertices;
+
+    if (!origins)
+        return false;
+
+    unsigned int origin = first_bit_position(origins);
+    unsigned int best = UINT_MAX;
+
+    for (uint64_t rest = origins; rest; rest &= ~(FIRST_BIT >> first_bit_position(rest)))
     {
-        if (!both_in_tree)
+        unsigned int vertex = first_bit_position(rest);
+        unsigned int score = origin_score(iterator, vertex);
+
+        if (score < best)
         {
-            add_edge_alg(graph, edge, output, find_one, run_data);
-            remove_edge_from_tree_alg(graph, edge);
+            origin = vertex;
+            best = score;
         }
-        remove_edge_alg(graph, edge, output, find_one, run_data);
-        add_edge_to_graph_alg(graph, edge);
     }
-}
 
-bool find_hists_alg(Graph *input_graph, uint64_t hidden_vertices, Output *output, bool find_one, RunData *run_data)
-{
-    if (run_data == NULL)
+    AdjListNeighbourArray *neighbours = &graph->neighbours[origin];
+    AdjListNeighbour *chosen = NULL;
+    best = UINT_MAX;
+
+    for (unsigned int i = 0; i < neighbours->size; i++)
     {
-        fprintf(stderr, "No RunData struct provided.\n");
-        exit(EXIT_FAILURE);
+        AdjListNeighbour *neighbour = &neighbours->neighbours[i];
+        if (neighbour->edge->removed || neighbour->edge->selected)
+            continue;
+
+        unsigned int score = destination_score(iterator, neighbour->vertex);
+        if (chosen == NULL || score < best)
+        {
+            chosen = neighbour;
+            best = score;
+        }
     }
 
-    AdjListGraph *graph = alg_from_graph_and_hidden(input_graph, hidden_vertices);
+    if (chosen == NULL)
+        return false;
 
-    rd_start_run(run_data);
-    hists_alg(graph, output, find_one, run_data);
-    rd_finish_run(run_data);
+    *out_edge = chosen->edge;
+    *out_both_in_tree = graph->d_tree_degrees[chosen->vertex] > 0;
+    return true;
+}
 
-    free_alg(graph);
-    return run_data->hists_this_run != 0;
+unsigned int hist_score_none(HistIterator *iterator, unsigned int vertex)
+{
+    return 0;
 }
 
-bool is_hypohist_partials_alg(Graph *input_graph, Output *output, RunData *run_data)
+unsigned int hist_score_undecided(HistIterator *iterator, unsigned int vertex)
 {
-    if (run_data == NULL)
+    return iterator->graph->d_graph_degrees[vertex] - iterator->graph->d_tree_degrees[vertex];
+}
+
+unsigned int hist_score_graph_degree(HistIterator *iterator, unsigned int vertex)
+{
+    return iterator->graph->d_graph_degrees[vertex];
+}
+
+unsigned int hist_score_grow(HistIterator *iterator, unsigned int vertex)
+{
+    return (iterator->graph->d_tree_degrees[vertex] == 2 ? 0 : 64) + iterator->graph->d_graph_degrees[vertex];
+}
+
+unsigned int hist_score_risk(HistIterator *iterator, unsigned int vertex)
+{
+    if (iterator->graph->d_tree_degrees[vertex] == 2)
+        return 0;
+
+    if (iterator->graph->d_graph_degrees[vertex] == 3)
+        return 1;
+
+    return 2 + iterator->graph->d_graph_degrees[vertex];
+}
+
+unsigned int hist_score_weighted(HistIterator *iterator, unsigned int vertex)
+{
+    return (hist_score_undecided(iterator, vertex) << 16) / iterator->weights[vertex];
+}
+
+bool hist_branch_min_degree(HistIterator *iterator, AdjListEdge **out_edge, bool *out_both_in_tree)
+{
+    return get_next_edge_alg(iterator->graph, out_edge, out_both_in_tree);
+}
+
+bool hist_branch_index(HistIterator *iterator, AdjListEdge **out_edge, bool *out_both_in_tree)
+{
+    return hist_branch_by_scores(iterator, hist_score_none, hist_score_none, out_edge, out_both_in_tree);
+}
+
+bool hist_branch_constrained(HistIterator *iterator, AdjListEdge **out_edge, bool *out_both_in_tree)
+{
+    return hist_branch_by_scores(iterator, hist_score_undecided, hist_score_undecided, out_edge, out_both_in_tree);
+}
+
+bool hist_branch_grow(HistIterator *iterator, AdjListEdge **out_edge, bool *out_both_in_tree)
+{
+    return hist_branch_by_scores(iterator, hist_score_grow, hist_score_graph_degree, out_edge, out_both_in_tree);
+}
+
+bool hist_branch_risk(HistIterator *iterator, AdjListEdge **out_edge, bool *out_both_in_tree)
+{
+    return hist_branch_by_scores(iterator, hist_score_risk, hist_score_risk, out_edge, out_both_in_tree);
+}
+
+bool hist_branch_weighted(HistIterator *iterator, AdjListEdge **out_edge, bool *out_both_in_tree)
+{
+    return hist_branch_by_scores(iterator, hist_score_weighted, hist_score_weighted, out_edge, out_both_in_tree);
+}
+
+const HistBranching HIST_BRANCHINGS[] = {
+    {"min-degree", hist_branch_min_degree},
+    {"index", hist_branch_index},
+    {"constrained", hist_branch_constrained},
+    {"grow", hist_branch_grow},
+    {"risk", hist_branch_risk},
+    {"weighted", hist_branch_weighted},
+};
+const unsigned int NB_HIST_BRANCHINGS = sizeof(HIST_BRANCHINGS) / sizeof(HIST_BRANCHINGS[0]);
+const HistBranching *const hist_default_branching = &HIST_BRANCHINGS[0];
+
+const HistBranching *hist_branching_by_name(const char *name)
+{
+    for (unsigned int i = 0; i < NB_HIST_BRANCHINGS; i++)
     {
-        fprintf(stderr, "No RunData struct provided.\n");
-        exit(EXIT_FAILURE);
+        if (strcmp(HIST_BRANCHINGS[i].name, name) == 0)
+            return &HIST_BRANCHINGS[i];
     }
 
-    for (unsigned int vertex = 0; vertex < input_graph->vertices; vertex++)
+    return NULL;
+}
+
+/*
+ * Conflict analysis
+ * The explanations below list edges whose current state already rules out every HIST,
+ * edges the search didn't change, like those of hidden vertices, are left out by the analysis.
+ */
+void hist_learn_add_conflict(AdjListLearning *learning, AdjListEdge *edge)
+{
+    learning->conflict[learning->conflict_size++] = edge;
+}
+
+// Decided edges at the vertex apart from the given one, which fix its degree bounds
+void hist_learn_explain_vertex(HistIterator *iterator, unsigned int vertex, AdjListEdge *except)
+{
+    AdjListNeighbourArray *neighbours = &iterator->graph->neighbours[vertex];
+
+    for (unsigned int i = 0; i < neighbours->size; i++)
     {
-        uint64_t hidden_vertex = FIRST_BIT >> vertex;
-        if (!find_hists_alg(input_graph, hidden_vertex, output, true, run_data))
-            return false;
+        AdjListEdge *edge = neighbours->neighbours[i].edge;
+        if (edge != except && (edge->removed || edge->selected))
+            hist_learn_add_conflict(iterator->learning, edge);
     }
+}
 
-    return true;
+// Removed edges across the cut the bridge spans, without them it wouldn't be a bridge
+void hist_learn_explain_bridge(HistIterator *iterator, AdjListEdge *bridge)
+{
+    AdjListGraph *graph = iterator->graph;
+    uint64_t side = alg_side_of_edge(graph, bridge);
+
+    for (unsigned int i = 0; i < graph->edges->size; i++)
+    {
+        AdjListEdge *edge = &graph->edges->edges[i];
+        bool origin_inside = (FIRST_BIT >> edge->origin) & side;
+        bool destination_inside = (FIRST_BIT >> edge->destination) & side;
+
+        if (edge->removed && origin_inside != destination_inside)
+            hist_learn_add_conflict(iterator->learning, edge);
+    }
+}
+
+// Tree edges on the path between the endpoints, which would close a cycle with the edge
+void hist_learn_explain_cycle(HistIterator *iterator, AdjListEdge *edge)
+{
+    AdjListGraph *graph = iterator->graph;
+    AdjListEdge *parent_edges[64];
+    unsigned int parents[64];
+    unsigned int queue[64];
+    unsigned int head = 0;
+    unsigned int tail = 0;
+    uint64_t reached = FIRST_BIT >> edge->origin;
+
+    queue[tail++] = edge->origin;
+
+    while (head < tail && !(reached & (FIRST_BIT >> edge->destination)))
+    {
+        unsigned int vertex = queue[head++];
+        AdjListNeighbourArray *neighbours = &graph->neighbours[vertex];
+
+        for (unsigned int i = 0; i < neighbours->size; i++)
+        {
+            AdjListNeighbour neighbour = neighbours->neighbours[i];
+            if (!neighbour.edge->selected || (reached & (FIRST_BIT >> neighbour.vertex)))
+                continue;
+
+            reached |= FIRST_BIT >> neighbour.vertex;
+            parents[neighbour.vertex] = vertex;
+            parent_edges[neighbour.vertex] = neighbour.edge;
+            queue[tail++] = neighbour.vertex;
+        }
+    }
+
+    for (unsigned int vertex = edge->destination; vertex != edge->origin; vertex = parents[vertex])
+        hist_learn_add_conflict(iterator->learning, parent_edges[vertex]);
+}
+
+// Explains why hist_impossible holds after changing the edge
+void hist_learn_explain_impossible(HistIterator *iterator, AdjListEdge *edge)
+{
+    AdjListGraph *graph = iterator->graph;
+    unsigned int *graph_d = graph->d_graph_degrees;
+    unsigned int *tree_d = graph->d_tree_degrees;
+    unsigned int endpoints[2] = {edge->origin, edge->destination};
+
+    iterator->learning->conflict_size = 0;
+
+    for (int i = 0; i < 2; i++)
+    {
+        unsigned int vertex = endpoints[i];
+        if (graph_d[vertex] == 0 || (graph_d[vertex] == 2 && tree_d[vertex] == 2))
+        {
+            hist_learn_explain_vertex(iterator, vertex, NULL);
+            return;
+        }
+    }
+
+    // The lower bound only grows with tree edges at vertices of tree degree 2 or more,
+    // the upper bound only shrinks with removed edges
+    bool too_many = graph->d_min_degree_sum > 2 * (graph->nb_available_vertices - 1);
+
+    for (unsigned int i = 0; i < graph->edges->size; i++)
+    {
+        AdjListEdge *other = &graph->edges->edges[i];
+
+        if (too_many ? other->selected && (tree_d[other->origin] > 1 || tree_d[other->destination] > 1) : other->removed)
+            hist_learn_add_conflict(iterator->learning, other);
+    }
+}
+
+// Stores the decided edges at the vertex as the reason for the change pushed next
+void hist_learn_reason(HistIterator *iterator, unsigned int vertex, AdjListEdge *forced)
+{
+    AdjListLearning *learning = iterator->learning;
+    AdjListNeighbourArray *neighbours = &iterator->graph->neighbours[vertex];
+
+    if (learning->nb_reasons + neighbours->size > learning->reasons_capacity)
+    {
+        learning->reasons_capacity = 2 * learning->reasons_capacity + neighbours->size;
+        learning->reasons = realloc(learning->reasons, learning->reasons_capacity * sizeof(AdjListEdge *));
+
+        if (learning->reasons == NULL)
+        {
+            fprintf(stderr, "Failed to allocate conflict analysis\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    learning->pending_reason = learning->nb_reasons;
+
+    for (unsigned int i = 0; i < neighbours->size; i++)
+    {
+        AdjListEdge *edge = neighbours->neighbours[i].edge;
+        if (edge != forced && (edge->removed || edge->selected))
+            learning->reasons[learning->nb_reasons++] = edge;
+    }
+}
+
+void hist_learn_mark(HistIterator *iterator, AdjListEdge *edge, unsigned int *top)
+{
+    unsigned int position = hist_learn_position(iterator, edge);
+    if (position == UINT_MAX)
+        return;
+
+    iterator->learning->seen[position] = true;
+    if (position + 1 > *top)
+        *top = position + 1;
+}
+
+// Follows the edges of the conflict back through their reasons to the decisions they came from.
+// Reasons always lie earlier on the trail, so a single pass from the back visits every change once.
+void hist_learn_analyze(HistIterator *iterator, uint64_t *set)
+{
+    AdjListLearning *learning = iterator->learning;
+    unsigned int top = 0;
+
+    memset(set, 0, learning->words * sizeof(uint64_t));
+
+    for (unsigned int i = 0; i < learning->conflict_size; i++)
+        hist_learn_mark(iterator, learning->conflict[i], &top);
+
+    for (unsigned int position = top; position-- > 0;)
+    {
+        if (!learning->seen[position])
+            continue;
+
+        learning->seen[position] = false;
+
+        if (learning->reason_starts[position] == UINT_MAX)
+        {
+            unsigned int level = learning->levels[position];
+            set[level / 64] |= 1ULL << (level % 64);
+            continue;
+        }
+
+        AdjListEdge **reason = &learning->reasons[learning->reason_starts[position]];
+        for (unsigned int i = 0; i < learning->reason_sizes[position]; i++)
+            hist_learn_mark(iterator, reason[i], &top);
+    }
+}
+
+// Conflict that depends on every decision made so far
+void hist_learn_explain_all(HistIterator *iterator)
+{
+    iterator->learning->conflict_size = 0;
+
+    for (unsigned int i = 0; i < iterator->nb_decisions; i++)
+        hist_learn_add_conflict(iterator->learning, iterator->decisions[i].edge);
+}
+
+bool hist_learn_literal_holds(HistIterator *iterator, unsigned int literal)
+{
+    AdjListEdge *edge = &iterator->graph->edges->edges[literal / 2];
+
+    if (literal % 2)
+        return edge->removed && hist_learn_position(iterator, edge) != UINT_MAX;
+
+    return edge->selected;
+}
+
+void hist_learn_watch(AdjListLearning *learning, int id)
+{
+    AdjListNogood *nogood = &learning->nogoods[id];
+    int *head = &learning->watches[nogood->literals[nogood->watched]];
+
+    nogood->previous = -1;
+    nogood->next = *head;
+    if (*head >= 0)
+        learning->nogoods[*head].previous = id;
+    *head = id;
+}
+
+void hist_learn_unwatch(AdjListLearning *learning, int id)
+{
+    AdjListNogood *nogood = &learning->nogoods[id];
+
+    if (nogood->previous >= 0)
+        learning->nogoods[nogood->previous].next = nogood->next;
+    else
+        learning->watches[nogood->literals[nogood->watched]] = nogood->next;
+
+    if (nogood->next >= 0)
+        learning->nogoods[nogood->next].previous = nogood->previous;
+}
+
+// Stores the decisions in the set as a nogood watched on the deepest one, which backjumping undoes next
+void hist_learn_nogood(HistIterator *iterator, uint64_t *set)
+{
+    AdjListLearning *learning = iterator->learning;
+    unsigned int size = 0;
+
+    for (unsigned int i = 0; i < learning->words; i++)
+        size += __builtin_popcountll(set[i]);
+
+    if (size == 0 || size > NOGOOD_MAX_LITERALS)
+        return;
+
+    int id = learning->nb_nogoods % NOGOOD_SLOTS;
+    if (learning->nb_nogoods >= NOGOOD_SLOTS)
+        hist_learn_unwatch(learning, id);
+    learning->nb_nogoods++;
+
+    AdjListNogood *nogood = &learning->nogoods[id];
+    nogood->size = 0;
+
+    for (unsigned int level = 0; level < iterator->nb_decisions; level++)
+    {
+        if (!(set[level / 64] & (1ULL << (level % 64))))
+            continue;
+
+        AdjListDecision *decision = &iterator->decisions[level];
+        nogood->literals[nogood->size++] = 2 * hist_learn_edge_index(iterator, decision->edge) + decision->removing;
+    }
+
+    nogood->watched = nogood->size - 1;
+    hist_learn_watch(learning, id);
+}
+
+// Moves the watches of the literals made true since the trail position, fails when a nogood can't move
+bool hist_learn_check_nogoods(HistIterator *iterator, unsigned int from)
+{
+    AdjListLearning *learning = iterator->learning;
+
+    for (unsigned int position = from; position < iterator->trail_size; position++)
+    {
+        AdjListTrailEntry *entry = &iterator->trail[position];
+        unsigned int literal = 2 * hist_learn_edge_index(iterator, entry->edge) + (entry->operation == TrailGraphRemove);
+
+        for (int id = learning->watches[literal]; id >= 0;)
+        {
+            AdjListNogood *nogood = &learning->nogoods[id];
+            int next = nogood->next;
+
+            unsigned int other = 0;
+            while (other < nogood->size && (other == nogood->watched || hist_learn_literal_holds(iterator, nogood->literals[other])))
+                other++;
+
+            if (other == nogood->size)
+            {
+                learning->conflict_size = 0;
+                for (unsigned int i = 0; i < nogood->size; i++)
+                    hist_learn_add_conflict(learning, &iterator->graph->edges->edges[nogood->literals[i] / 2]);
+
+                return false;
+            }
+
+            hist_learn_unwatch(learning, id);
+            nogood->watched = other;
+            hist_learn_watch(learning, id);
+            id = next;
+        }
+    }
+
+    return true;
+}
+
+// Applies the moves forced by the degrees of the endpoints of the changed edge, and of every edge changed by
+// such a move. They are pushed on the trail after the decision, so they are undone together with it.
+// A vertex with a single undecided edge has to take it with tree degree 2 or 0, and has to drop it with tree
+// degree 1. A vertex outside the tree only takes it when that keeps the tree connected.
+// Returns false when a forced move closes a cycle, disconnects the graph or can't lead to a HIST.
+bool hist_iter_propagate(HistIterator *iterator, AdjListEdge *edge)
+{
+    AdjListGraph *graph = iterator->graph;
+    AdjListLearning *learning = iterator->learning && iterator->learning->active ? iterator->learning : NULL;
+    uint64_t pending = (FIRST_BIT >> edge->origin) | (FIRST_BIT >> edge->destination);
+
+    while (pending)
+    {
+        unsigned int vertex = first_bit_position(pending);
+        pending &= ~(FIRST_BIT >> vertex);
+
+        unsigned int tree_degree = graph->d_tree_degrees[vertex];
+        if (tree_degree > 2 || graph->d_graph_degrees[vertex] != tree_degree + 1)
+            continue;
+
+        AdjListNeighbourArray *neighbours = &graph->neighbours[vertex];
+        AdjListNeighbour *neighbour = NULL;
+        for (unsigned int i = 0; i < neighbours->size && neighbour == NULL; i++)
+        {
+            AdjListEdge *candidate = neighbours->neighbours[i].edge;
+            if (!candidate->removed && !candidate->selected)
+                neighbour = &neighbours->neighbours[i];
+        }
+
+        AdjListEdge *forced = neighbour->edge;
+        bool other_in_tree = graph->d_tree_degrees[neighbour->vertex] > 0;
+
+        if (tree_degree == 1)
+        {
+            if (alg_is_bridge(graph, forced))
+            {
+                if (learning)
+                {
+                    learning->conflict_size = 0;
+                    hist_learn_explain_vertex(iterator, vertex, forced);
+                    hist_learn_explain_bridge(iterator, forced);
+                }
+
+                return false;
+            }
+
+            if (learning)
+                hist_learn_reason(iterator, vertex, forced);
+
+            remove_edge_from_graph_alg(graph, forced);
+            hist_iter_push_trail(iterator, forced, TrailGraphRemove);
+        }
+        else
+        {
+            if (tree_degree == 2 && other_in_tree)
+            {
+                if (learning)
+                {
+                    learning->conflict_size = 0;
+                    hist_learn_explain_vertex(iterator, vertex, forced);
+                    hist_learn_explain_cycle(iterator, forced);
+                }
+
+                return false;
+            }
+
+            if (tree_degree == 0 && !other_in_tree && graph->d_nb_tree_edges > 0)
+                continue;
+
+            if (learning)
+                hist_learn_reason(iterator, vertex, forced);
+
+            add_edge_to_tree_alg(graph, forced);
+            hist_iter_push_trail(iterator, forced, TrailTreeAdd);
+        }
+
+        if (hist_impossible(graph, forced))
+        {
+            if (learning)
+                hist_learn_explain_impossible(iterator, forced);
+
+            return false;
+        }
+
+        pending |= (FIRST_BIT >> forced->origin) | (FIRST_BIT >> forced->destination);
+    }
+
+    return true;
+}
+
+// Applies the branch the decision is currently on, returns false when that branch can't lead to a HIST
+bool hist_iter_apply(HistIterator *iterator, AdjListDecision *decision)
+{
+    AdjListGraph *graph = iterator->graph;
+    AdjListEdge *edge = decision->edge;
+
+    if (decision->removing)
+    {
+        remove_edge_from_graph_alg(graph, edge);
+        hist_iter_push_trail(iterator, edge, TrailGraphRemove);
+    }
+    else
+    {
+        add_edge_to_tree_alg(graph, edge);
+        hist_iter_push_trail(iterator, edge, TrailTreeAdd);
+    }
+
+    bool learning = iterator->learning && iterator->learning->active;
+
+    if (hist_impossible(graph, edge))
+    {
+        if (learning)
+            hist_learn_explain_impossible(iterator, edge);
+
+        return false;
+    }
+
+    if (!hist_iter_propagate(iterator, edge))
+        return false;
+
+    return !learning || hist_learn_check_nogoods(iterator, decision->trail_start);
+}
+
+// Undoes decisions until one has an unexplored branch and applies that branch.
+// Returns false when the search space is exhausted.
+bool hist_iter_backtrack(HistIterator *iterator)
+{
+    while (iterator->nb_decisions > 0)
+    {
+        AdjListDecision *decision = &iterator->decisions[iterator->nb_decisions - 1];
+        hist_iter_undo_to(iterator, decision->trail_start);
+
+        if (decision->removing || decision->forced)
+        {
+            iterator->nb_decisions--;
+            continue;
+        }
+
+        decision->removing = true;
+        if (hist_iter_apply(iterator, decision))
+            return true;
+    }
+
+    return false;
+}
+
+// Backtracks from a failure explained by the conflict. Decisions the failure doesn't depend on
+// are undone without trying their other branch, since it fails for the same reason.
+bool hist_iter_backjump(HistIterator *iterator)
+{
+    AdjListLearning *learning = iterator->learning;
+    unsigned int words = learning->words;
+    uint64_t *failure = learning->failure;
+
+    hist_learn_analyze(iterator, failure);
+
+    while (iterator->nb_decisions > 0)
+    {
+        unsigned int level = iterator->nb_decisions - 1;
+        AdjListDecision *decision = &iterator->decisions[level];
+        uint64_t *branch_set = &learning->branch_sets[(size_t)level * words];
+        hist_iter_undo_to(iterator, decision->trail_start);
+
+        if (!(failure[level / 64] & (1ULL << (level % 64))))
+        {
+            iterator->nb_decisions--;
+            continue;
+        }
+
+        failure[level / 64] &= ~(1ULL << (level % 64));
+
+        if (decision->removing || decision->forced)
+        {
+            // Both branches failed, the decisions before this one that either depended on rule it out
+            for (unsigned int i = 0; i < words; i++)
+                failure[i] |= branch_set[i];
+
+            iterator->nb_decisions--;
+            hist_learn_nogood(iterator, failure);
+            continue;
+        }
+
+        memcpy(branch_set, failure, words * sizeof(uint64_t));
+
+        decision->removing = true;
+        if (hist_iter_apply(iterator, decision))
+            return true;
+
+        hist_learn_analyze(iterator, failure);
+    }
+
+    return false;
+}
+
+// Backtracks after a failed branch, or interrupts the search once the failure limit is exceeded
+bool hist_iter_fail(HistIterator *iterator, bool learning)
+{
+    iterator->failures += 1;
+
+    if (iterator->nb_decisions > 0)
+    {
+        AdjListEdge *edge = iterator->decisions[iterator->nb_decisions - 1].edge;
+        iterator->weights[edge->origin] += 1;
+        iterator->weights[edge->destination] += 1;
+    }
+
+    if (iterator->failure_limit && iterator->failures > iterator->failure_limit)
+    {
+        iterator->interrupted = true;
+        return false;
+    }
+
+    return learning ? hist_iter_backjump(iterator) : hist_iter_backtrack(iterator);
+}
+
+/*
+ * Endgame
+ */
+// Sets up the endgame for the undecided edges, of which there are at most HIST_ENDGAME_EDGES
+void hist_endgame_start(HistIterator *iterator)
+{
+    AdjListGraph *graph = iterator->graph;
+    HistEndgame *endgame = &iterator->endgame;
+    uint64_t tree_adjacencies[64] = {0};
+    int positions[64];
+
+    endgame->active = true;
+    endgame->nb_edges = 0;
+    endgame->nb_vertices = 0;
+
+    for (unsigned int i = 0; i < graph->edges->size; i++)
+    {
+        AdjListEdge *edge = &graph->edges->edges[i];
+
+        if (edge->selected)
+        {
+            tree_adjacencies[edge->origin] |= FIRST_BIT >> edge->destination;
+            tree_adjacencies[edge->destination] |= FIRST_BIT >> edge->origin;
+        }
+        else if (!edge->removed)
+        {
+            endgame->edges[endgame->nb_edges++] = edge;
+        }
+    }
+
+    // Every vertex is in a component of the tree, on its own if it has no tree edges
+    int components[64];
+    unsigned int nb_components = 0;
+    uint64_t unassigned = graph->available_vertices;
+
+    while (unassigned)
+    {
+        uint64_t component = FIRST_BIT >> first_bit_position(unassigned);
+        uint64_t frontier = component;
+
+        while (frontier)
+        {
+            uint64_t next = 0;
+            for (uint64_t rest = frontier; rest; rest &= rest - 1)
+                next |= tree_adjacencies[last_bit_position(rest)];
+
+            frontier = next & ~component;
+            component |= frontier;
+        }
+
+        for (uint64_t rest = component; rest; rest &= rest - 1)
+            components[last_bit_position(rest)] = nb_components;
+
+        nb_components++;
+        unassigned &= ~component;
+    }
+
+    uint64_t endpoints = 0;
+    for (unsigned int v = 0; v < graph->vertices; v++)
+        positions[v] = -1;
+
+    for (unsigned int e = 0; e < endgame->nb_edges; e++)
+    {
+        unsigned int ends[2] = {endgame->edges[e]->origin, endgame->edges[e]->destination};
+
+        for (unsigned int side = 0; side < 2; side++)
+        {
+            unsigned int vertex = ends[side];
+            endgame->components[e][side] = components[vertex];
+
+            if (positions[vertex] < 0)
+            {
+                positions[vertex] = endgame->nb_vertices++;
+                endgame->tree_degrees[positions[vertex]] = graph->d_tree_degrees[vertex];
+                endgame->incidences[positions[vertex]] = 0;
+                endpoints |= FIRST_BIT >> vertex;
+            }
+
+            endgame->incidences[positions[vertex]] |= 1U << e;
+        }
+    }
+
+    // The subsets have to join the components, and can't change a vertex without undecided edges
+    unsigned int needed = nb_components - 1;
+    bool possible = needed <= endgame->nb_edges;
+
+    for (uint64_t rest = graph->available_vertices & ~endpoints; rest && possible; rest &= rest - 1)
+        possible = graph->d_tree_degrees[last_bit_position(rest)] != 2;
+
+    if (!possible)
+    {
+        endgame->subset = 1;
+        endgame->last = 0;
+        return;
+    }
+
+    endgame->subset = (1U << needed) - 1;
+    endgame->last = endgame->subset << (endgame->nb_edges - needed);
+}
+
+// Whether the edges of the subset join the components of the tree into a single tree
+bool hist_endgame_joins(HistEndgame *endgame, uint32_t subset)
+{
+    unsigned int parents[64];
+
+    for (uint32_t rest = subset; rest; rest &= rest - 1)
+    {
+        unsigned int e = __builtin_ctz(rest);
+        parents[endgame->components[e][0]] = endgame->components[e][0];
+        parents[endgame->components[e][1]] = endgame->components[e][1];
+    }
+
+    for (uint32_t rest = subset; rest; rest &= rest - 1)
+    {
+        unsigned int e = __builtin_ctz(rest);
+        unsigned int a = endgame->components[e][0];
+        unsigned int b = endgame->components[e][1];
+
+        while (parents[a] != a)
+            a = parents[a];
+        while (parents[b] != b)
+            b = parents[b];
+
+        if (a == b)
+            return false;
+
+        parents[a] = b;
+    }
+
+    return true;
+}
+
+// Tests the remaining subsets until one completes the tree to a HIST, which is written to tree when it is not NULL
+bool hist_endgame_next(HistIterator *iterator, Graph *tree)
+{
+    HistEndgame *endgame = &iterator->endgame;
+
+    while (endgame->subset <= endgame->last)
+    {
+        uint32_t subset = endgame->subset;
+
+        // Next subset with the same number of edges
+        uint32_t lowest = subset & -subset;
+        uint32_t ripple = subset + lowest;
+        endgame->subset = (((ripple ^ subset) >> 2) / lowest) | ripple;
+
+        bool valid = true;
+        for (unsigned int i = 0; i < endgame->nb_vertices && valid; i++)
+            valid = endgame->tree_degrees[i] + count_set_bits(subset & endgame->incidences[i]) != 2;
+
+        if (!valid || !hist_endgame_joins(endgame, subset))
+            continue;
+
+        iterator->trees += 1;
+        iterator->hists += 1;
+
+        if (tree)
+        {
+            fill_tree(iterator->graph, tree);
+
+            for (uint32_t rest = subset; rest; rest &= rest - 1)
+            {
+                AdjListEdge *edge = endgame->edges[__builtin_ctz(rest)];
+                add_edge_to_graph(tree, &(Edge){edge->origin, edge->destination});
+            }
+        }
+
+        return true;
+    }
+
+    endgame->active = false;
+    return false;
+}
+
+// Searches for the next HIST, the selected edges are written to tree when it is not NULL.
+// Returns false when there are no more HISTs.
+bool hist_iter_next(HistIterator *iterator, Graph *tree)
+{
+    AdjListGraph *graph = iterator->graph;
+
+    // An interrupted search has to be reset before it can run again
+    if (iterator->exhausted || iterator->interrupted)
+        return false;
+
+    bool expanding = true;
+    AdjListLearning *learning = iterator->learning;
+
+    // The search below the last HIST is not a failure, so it can't be explained by a conflict
+    if (iterator->started && learning)
+        learning->active = false;
+
+    // The endgame the last HIST came from may have more of them
+    if (iterator->endgame.active && hist_endgame_next(iterator, tree))
+        return true;
+
+    if (iterator->started)
+        expanding = hist_iter_backtrack(iterator);
+
+    iterator->started = true;
+
+    if (learning && !learning->active)
+        learning = NULL;
+
+    while (expanding)
+    {
+        if (tree_is_finished_alg(graph))
+        {
+            iterator->trees += 1;
+
+            if (is_valid_hist_alg(graph))
+            {
+                iterator->hists += 1;
+
+                if (tree)
+                    fill_tree(graph, tree);
+
+                return true;
+            }
+
+            if (learning)
+            {
+                // Any HIST with all these edges would be this tree
+                learning->conflict_size = 0;
+                for (unsigned int i = 0; i < graph->edges->size; i++)
+                {
+                    if (graph->edges->edges[i].selected)
+                        hist_learn_add_conflict(learning, &graph->edges->edges[i]);
+                }
+            }
+
+            expanding = hist_iter_fail(iterator, learning != NULL);
+            continue;
+        }
+
+        if (graph->d_nb_graph_edges - graph->d_nb_tree_edges <= HIST_ENDGAME_EDGES)
+        {
+            hist_endgame_start(iterator);
+
+            if (hist_endgame_next(iterator, tree))
+                return true;
+
+            if (learning)
+                hist_learn_explain_all(iterator);
+
+            expanding = hist_iter_fail(iterator, learning != NULL);
+            continue;
+        }
+
+        AdjListEdge *edge;
+        bool both_in_tree = false;
+        if (!iterator->branching->next_edge(iterator, &edge, &both_in_tree))
+        {
+            if (learning)
+                hist_learn_explain_all(iterator);
+
+            expanding = hist_iter_fail(iterator, learning != NULL);
+            continue;
+        }
+
+        AdjListDecision *decision = &iterator->decisions[iterator->nb_decisions++];
+        decision->edge = edge;
+        decision->trail_start = iterator->trail_size;
+        // Adding an edge between two tree vertices would close a cycle, so only removing is possible.
+        // Such an edge is never a bridge, any other bridge has to be in the tree.
+        decision->removing = both_in_tree;
+        decision->forced = !both_in_tree && alg_is_bridge(graph, edge);
+
+        // The skipped branch would close a cycle or cut the graph, so its failure depends on the decisions behind those
+        if (learning && (decision->removing || decision->forced))
+        {
+            learning->conflict_size = 0;
+            if (both_in_tree)
+                hist_learn_explain_cycle(iterator, edge);
+            else
+                hist_learn_explain_bridge(iterator, edge);
+
+            hist_learn_analyze(iterator, &learning->branch_sets[(size_t)(iterator->nb_decisions - 1) * learning->words]);
+        }
+
+        if (!hist_iter_apply(iterator, decision))
+            expanding = hist_iter_fail(iterator, learning != NULL);
+    }
+
+    iterator->exhausted = !iterator->interrupted;
+    return false;
+}
+
+// Undoes all changes to the graph so the search can be started again
+void hist_iter_reset(HistIterator *iterator)
+{
+    hist_iter_undo_to(iterator, 0);
+
+    iterator->nb_decisions = 0;
+    iterator->started = false;
+    iterator->exhausted = false;
+    iterator->trees = 0;
+    iterator->hists = 0;
+    iterator->failures = 0;
+    iterator->interrupted = false;
+    iterator->endgame.active = false;
+
+    for (unsigned int v = 0; v < iterator->graph->vertices; v++)
+        iterator->weights[v] = 1;
+
+    // Hidden vertices may change before the next search, which can make the nogoods wrong
+    if (iterator->learning)
+        hist_learn_clear(iterator->learning, iterator->graph->edges->size);
+}
+
+// Also restores the graph when the search was stopped early
+void free_hist_iter(HistIterator *iterator)
+{
+    hist_iter_reset(iterator);
+
+    free(iterator->trail);
+    free(iterator->decisions);
+    free(iterator->weights);
+
+    AdjListLearning *learning = iterator->learning;
+    if (learning)
+    {
+        free(learning->positions);
+        free(learning->levels);
+        free(learning->reason_starts);
+        free(learning->reason_sizes);
+        free(learning->reasons);
+        free(learning->conflict);
+        free(learning->branch_sets);
+        free(learning->failure);
+        free(learning->seen);
+        free(learning->nogoods);
+        free(learning->watches);
+        free(learning);
+    }
+}
+
+void hists_alg(AdjListGraph *graph, const HistBranching *branching, Output *output, bool find_one, RunData *run_data)
+{
+    HistIterator iterator;
+    hist_iter_init(&iterator, graph, branching);
+
+    if (find_one)
+        hist_iter_learn(&iterator);
+
+    Graph *tree = output ? empty_graph(graph->vertices) : NULL;
+
+    while (hist_iter_next(&iterator, tree))
+    {
+        if (output)
+            print_graph_to_output(output, tree);
+
+        run_data->hists_this_run += 1;
+
+        if (find_one)
+            break;
+    }
+
+    run_data->trees_this_run += iterator.trees;
+
+    if (tree)
+        free_graph(tree);
+
+    free_hist_iter(&iterator);
+}
+
+bool run_hists_alg(AdjListGraph *graph, const HistBranching *branching, Output *output, bool find_one, RunData *run_data)
+{
+    if (run_data == NULL)
+    {
+        fprintf(stderr, "No RunData struct provided.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    rd_start_run(run_data);
+    hists_alg(graph, branching, output, find_one, run_data);
+    rd_finish_run(run_data);
+
+    return run_data->hists_this_run != 0;
+}
+
+bool find_hists_alg_ws(AdjListWorkspace *workspace, Graph *input_graph, uint64_t hidden_vertices, const HistBranching *branching, Output *output, bool find_one, RunData *run_data)
+{
+    AdjListGraph *graph = alg_from_graph_and_hidden_ws(workspace, input_graph, hidden_vertices);
+    return run_hists_alg(graph, branching, output, find_one, run_data);
+}
+
+bool find_hists_alg(Graph *input_graph, uint64_t hidden_vertices, Output *output, bool find_one, RunData *run_data)
+{
+    AdjListWorkspace *workspace = alw_new();
+    bool found = find_hists_alg_ws(workspace, input_graph, hidden_vertices, hist_default_branching, output, find_one, run_data);
+    free_alw(workspace);
+    return found;
+}
+
+// Checks every vertex deleted graph on a single AdjListGraph by hiding one vertex at a time
+bool is_hypohist_partials_alg(Graph *input_graph, Output *output, RunData *run_data)
+{
+    if (run_data == NULL)
+    {
+        fprintf(stderr, "No RunData struct provided.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    AdjListGraph *graph = alg_from_graph_and_hidden(input_graph, 0);
+    Graph *tree = output ? empty_graph(graph->vertices) : NULL;
+    bool hypohist = true;
+
+    HistIterator iterator;
+    hist_iter_init(&iterator, graph, hist_default_branching);
+    hist_iter_learn(&iterator);
+
+    for (unsigned int vertex = 0; vertex < input_graph->vertices && hypohist; vertex++)
+    {
+        alg_hide_vertex(graph, vertex);
+
+        rd_start_run(run_data);
+        hypohist = hist_iter_next(&iterator, tree);
+
+        if (hypohist)
+        {
+            if (output)
+                print_graph_to_output(output, tree);
+
+            run_data->hists_this_run += 1;
+        }
+
+        run_data->trees_this_run += iterator.trees;
+        rd_finish_run(run_data);
+
+        // Stopping after the first HIST, so the search has to be unwound before unhiding
+        hist_iter_reset(&iterator);
+        alg_unhide_vertex(graph, vertex);
+    }
+
+    free_hist_iter(&iterator);
+
+    if (tree)
+        free_graph(tree);
+
+    free_alg(graph);
+    return hypohist;
 }
 
 bool is_hypohist_alg(Graph *input_graph, Output *output, bool only_partials, RunData *run_data)
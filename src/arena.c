@@ -0,0 +1,84 @@
+#include <arena.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+Arena arena_new()
+{
+    Arena arena;
+
+    arena.data = NULL;
+    arena.size = 0;
+    arena.capacity = 0;
+
+    return arena;
+}
+
+// Number of bytes an allocation of the given size takes up in the arena
+size_t arena_aligned_size(size_t bytes)
+{
+    size_t alignment = sizeof(uint64_t);
+    return (bytes + alignment - 1) & ~(alignment - 1);
+}
+
+// Makes sure the arena can hold at least capacity bytes.
+// Growing moves the block, so this is only allowed while the arena is empty.
+void arena_reserve(Arena *arena, size_t capacity)
+{
+    if (capacity <= arena->capacity)
+        return;
+
+    if (arena->size != 0)
+    {
+        fprintf(stderr, "Attempting to grow an arena that is in use.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    free(arena->data);
+    arena->data = malloc(capacity);
+
+    if (arena->data == NULL)
+    {
+        fprintf(stderr, "Failed to allocate arena. Requested capacity: %zu\n", capacity);
+        exit(EXIT_FAILURE);
+    }
+
+    arena->capacity = capacity;
+}
+
+void *arena_alloc(Arena *arena, size_t bytes)
+{
+    size_t aligned = arena_aligned_size(bytes);
+
+    if (arena->capacity - arena->size < aligned)
+    {
+        fprintf(stderr, "Arena capacity exceeded. Requested: %zu, available: %zu\n", aligned, arena->capacity - arena->size);
+        exit(EXIT_FAILURE);
+    }
+
+    void *pointer = arena->data + arena->size;
+    arena->size += aligned;
+
+    return pointer;
+}
+
+void *arena_calloc(Arena *arena, size_t count, size_t size)
+{
+    void *pointer = arena_alloc(arena, count * size);
+    memset(pointer, 0, count * size);
+    return pointer;
+}
+
+void arena_reset(Arena *arena)
+{
+    arena->size = 0;
+}
+
+void free_arena(Arena *arena)
+{
+    free(arena->data);
+    arena->data = NULL;
+    arena->size = 0;
+    arena->capacity = 0;
+}
@@ -0,0 +1,205 @@
+#include <bignat.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+BigNat bignat_from_u64(uint64_t value)
+{
+    BigNat number = {{0}};
+    number.limbs[0] = value;
+    return number;
+}
+
+bool bignat_is_zero(BigNat *number)
+{
+    for (int i = 0; i < BIGNAT_LIMBS; i++)
+    {
+        if (number->limbs[i])
+            return false;
+    }
+
+    return true;
+}
+
+bool bignat_to_u64(BigNat *number, uint64_t *value)
+{
+    for (int i = 1; i < BIGNAT_LIMBS; i++)
+    {
+        if (number->limbs[i])
+            return false;
+    }
+
+    *value = number->limbs[0];
+    return true;
+}
+
+void bignat_add_u64(BigNat *number, uint64_t value)
+{
+    uint64_t carry = value;
+
+    for (int i = 0; i < BIGNAT_LIMBS && carry; i++)
+    {
+        number->limbs[i] += carry;
+        carry = number->limbs[i] < carry;
+    }
+
+    if (carry)
+    {
+        fprintf(stderr, "BigNat overflow in addition.\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+void bignat_add(BigNat *number, const BigNat *other)
+{
+    uint64_t carry = 0;
+
+    for (int i = 0; i < BIGNAT_LIMBS; i++)
+    {
+        uint64_t sum = number->limbs[i] + carry;
+        carry = sum < carry;
+        number->limbs[i] = sum + other->limbs[i];
+        carry += number->limbs[i] < sum;
+    }
+
+    if (carry)
+    {
+        fprintf(stderr, "BigNat overflow in addition.\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+void bignat_sub(BigNat *number, const BigNat *other)
+{
+    uint64_t borrow = 0;
+
+    for (int i = 0; i < BIGNAT_LIMBS; i++)
+    {
+        uint64_t difference = number->limbs[i] - other->limbs[i];
+        uint64_t next_borrow = number->limbs[i] < other->limbs[i] || difference < borrow;
+        number->limbs[i] = difference - borrow;
+        borrow = next_borrow;
+    }
+
+    if (borrow)
+    {
+        fprintf(stderr, "BigNat underflow in subtraction.\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+int bignat_compare(const BigNat *a, const BigNat *b)
+{
+    for (int i = BIGNAT_LIMBS - 1; i >= 0; i--)
+    {
+        if (a->limbs[i] != b->limbs[i])
+            return a->limbs[i] < b->limbs[i] ? -1 : 1;
+    }
+
+    return 0;
+}
+
+void bignat_mul(BigNat *number, const BigNat *other)
+{
+    uint64_t product[2 * BIGNAT_LIMBS] = {0};
+
+    for (int i = 0; i < BIGNAT_LIMBS; i++)
+    {
+        uint64_t carry = 0;
+
+        for (int j = 0; j < BIGNAT_LIMBS; j++)
+        {
+            unsigned __int128 current = (unsigned __int128)number->limbs[i] * other->limbs[j] + product[i + j] + carry;
+            product[i + j] = (uint64_t)current;
+            carry = (uint64_t)(current >> 64);
+        }
+
+        product[i + BIGNAT_LIMBS] = carry;
+    }
+
+    for (int i = BIGNAT_LIMBS; i < 2 * BIGNAT_LIMBS; i++)
+    {
+        if (product[i])
+        {
+            fprintf(stderr, "BigNat overflow in multiplication.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    for (int i = 0; i < BIGNAT_LIMBS; i++)
+        number->limbs[i] = product[i];
+}
+
+void bignat_mul_u64(BigNat *number, uint64_t value)
+{
+    uint64_t carry = 0;
+
+    for (int i = 0; i < BIGNAT_LIMBS; i++)
+    {
+        unsigned __int128 product = (unsigned __int128)number->limbs[i] * value + carry;
+        number->limbs[i] = (uint64_t)product;
+        carry = (uint64_t)(product >> 64);
+    }
+
+    if (carry)
+    {
+        fprintf(stderr, "BigNat overflow in multiplication.\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+uint64_t bignat_divmod_u64(BigNat *number, uint64_t divisor)
+{
+    unsigned __int128 remainder = 0;
+
+    for (int i = BIGNAT_LIMBS - 1; i >= 0; i--)
+    {
+        unsigned __int128 current = (remainder << 64) | number->limbs[i];
+        number->limbs[i] = (uint64_t)(current / divisor);
+        remainder = current % divisor;
+    }
+
+    return (uint64_t)remainder;
+}
+
+bool bignat_from_string(const char *string, BigNat *number)
+{
+    *number = bignat_from_u64(0);
+
+    if (*string == '\0')
+        return false;
+
+    for (; *string; string++)
+    {
+        if (*string < '0' || *string > '9')
+            return false;
+
+        // Keep overflow an input error instead of a fatal one
+        if (number->limbs[BIGNAT_LIMBS - 1] >> 59)
+            return false;
+
+        bignat_mul_u64(number, 10);
+        bignat_add_u64(number, *string - '0');
+    }
+
+    return true;
+}
+
+void bignat_to_string(BigNat *number, char *buffer)
+{
+    // Peel off chunks of 19 decimal digits, least significant first
+    const uint64_t chunk = 10000000000000000000ULL;
+    uint64_t chunks[BIGNAT_STRING_LENGTH / 19 + 1];
+    int nb_chunks = 0;
+
+    BigNat rest = *number;
+
+    do
+    {
+        chunks[nb_chunks++] = bignat_divmod_u64(&rest, chunk);
+    } while (!bignat_is_zero(&rest));
+
+    int length = sprintf(buffer, "%llu", (unsigned long long int)chunks[nb_chunks - 1]);
+
+    for (int i = nb_chunks - 2; i >= 0; i--)
+        length += sprintf(buffer + length, "%019llu", (unsigned long long int)chunks[i]);
+}
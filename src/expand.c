@@ -0,0 +1,131 @@
+#define _GNU_SOURCE
+#include <histg_lib.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Expands the factored output of winter into individual trees in graph6 format.
+// Every input line holds the number of vertices followed by space separated edge sets,
+// each set a comma separated list of edges 'origin-destination'. Every combination
+// that takes one edge from each set is a tree.
+
+typedef struct FactoredTrees
+{
+    unsigned int nb_vertices;
+    int nb_sets;
+    // Edges of set i are stored from set_offsets[i] up to set_offsets[i + 1]
+    int *set_offsets;
+    Edge *edges;
+} FactoredTrees;
+
+void parse_error(char *line)
+{
+    fprintf(stderr, "Invalid factored line: %s\n", line);
+    exit(EXIT_FAILURE);
+}
+
+int parse_vertex(char **position, char *line, unsigned int nb_vertices)
+{
+    char *end;
+    long vertex = strtol(*position, &end, 10);
+
+    if (end == *position || vertex < 0 || vertex >= nb_vertices)
+        parse_error(line);
+
+    *position = end;
+    return (int)vertex;
+}
+
+void parse_factored_line(char *line, FactoredTrees *factored)
+{
+    char *position = line;
+    char *end;
+    long nb_vertices = strtol(position, &end, 10);
+
+    if (end == position || nb_vertices < 1 || nb_vertices > 64)
+        parse_error(line);
+
+    position = end;
+    factored->nb_vertices = nb_vertices;
+    factored->nb_sets = 0;
+
+    int nb_edges = 0;
+    while (*position == ' ')
+    {
+        position++;
+        factored->set_offsets[factored->nb_sets] = nb_edges;
+
+        do
+        {
+            if (*position == ',')
+                position++;
+
+            if (nb_edges >= nb_vertices * (nb_vertices - 1) / 2)
+                parse_error(line);
+
+            Edge *edge = &factored->edges[nb_edges++];
+            edge->origin = parse_vertex(&position, line, nb_vertices);
+            if (*position != '-')
+                parse_error(line);
+            position++;
+            edge->destination = parse_vertex(&position, line, nb_vertices);
+        } while (*position == ',');
+
+        factored->nb_sets++;
+        if (factored->nb_sets >= nb_vertices)
+            parse_error(line);
+    }
+
+    if (*position != '\n' && *position != '\0')
+        parse_error(line);
+
+    if (factored->nb_sets != nb_vertices - 1)
+        parse_error(line);
+
+    factored->set_offsets[factored->nb_sets] = nb_edges;
+}
+
+void expand_parts(FactoredTrees *factored, Graph *tree, int set, FILE *output, unsigned long long int *nb_trees)
+{
+    if (set == factored->nb_sets)
+    {
+        print_graph_to_output_as_graph6(output, tree);
+        *nb_trees += 1;
+        return;
+    }
+
+    for (int i = factored->set_offsets[set]; i < factored->set_offsets[set + 1]; i++)
+    {
+        add_edge_to_graph(tree, &factored->edges[i]);
+        expand_parts(factored, tree, set + 1, output, nb_trees);
+        remove_edge_from_graph(tree, &factored->edges[i]);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    char *line = NULL;
+    size_t length = 0;
+    size_t read;
+
+    // Enough room for any graph with at most 64 vertices
+    FactoredTrees factored;
+    factored.set_offsets = malloc(65 * sizeof(int));
+    factored.edges = malloc(64 * 63 / 2 * sizeof(Edge));
+
+    unsigned long long int nb_trees = 0;
+
+    while ((read = getline(&line, &length, stdin)) != -1)
+    {
+        parse_factored_line(line, &factored);
+
+        Graph *tree = empty_graph(factored.nb_vertices);
+        expand_parts(&factored, tree, 0, stdout, &nb_trees);
+        free_graph(tree);
+    }
+
+    fprintf(stderr, "Trees: %llu\n", nb_trees);
+
+    free(line);
+    free(factored.set_offsets);
+    free(factored.edges);
+}
@@ -0,0 +1,254 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <hist_algebraic.h>
+#include <kirchhoff.h>
+#include <kirchhoff_batch.h>
+#include <modular.h>
+
+unsigned long long int algebraic_evaluations(Graph *graph)
+{
+    unsigned long long int evaluations = 1;
+
+    for (int v = 0; v < graph->vertices; v++)
+    {
+        evaluations *= vertex_degree(graph->adjacency_matrix[v]);
+
+        if (evaluations == 0 || evaluations > ALGEBRAIC_MAX_EVALUATIONS)
+            return evaluations ? ALGEBRAIC_MAX_EVALUATIONS + 1 : 0;
+    }
+
+    return evaluations;
+}
+
+// Weights w_j for the points t_j = j + 1, j < nb_points, such that sum_j w_j t_j^d = [d != 2] for 1 <= d <= nb_points.
+// The system is a Vandermonde matrix scaled by the points, so it is always solvable.
+void algebraic_weights(int nb_points, uint64_t p, uint64_t *weights)
+{
+    int n = nb_points;
+    uint64_t *system = malloc((n * (n + 1) + 1) * sizeof(uint64_t));
+
+    // Row d - 1 holds t_j^d for every point followed by the right hand side
+    for (int j = 0; j < n; j++)
+    {
+        uint64_t power = j + 1;
+        for (int d = 1; d <= n; d++)
+        {
+            system[(d - 1) * (n + 1) + j] = power;
+            power = mod_mul(power, j + 1, p);
+        }
+    }
+
+    for (int d = 1; d <= n; d++)
+        system[(d - 1) * (n + 1) + n] = d != 2;
+
+    // Gauss-Jordan elimination
+    for (int k = 0; k < n; k++)
+    {
+        int pivot = k;
+        while (system[pivot * (n + 1) + k] == 0)
+            pivot++;
+
+        for (int j = 0; j <= n; j++)
+        {
+            uint64_t temp = system[k * (n + 1) + j];
+            system[k * (n + 1) + j] = system[pivot * (n + 1) + j];
+            system[pivot * (n + 1) + j] = temp;
+        }
+
+        uint64_t inverse = mod_inverse(system[k * (n + 1) + k], p);
+        for (int j = 0; j <= n; j++)
+            system[k * (n + 1) + j] = mod_mul(system[k * (n + 1) + j], inverse, p);
+
+        for (int i = 0; i < n; i++)
+        {
+            uint64_t factor = system[i * (n + 1) + k];
+
+            if (i == k || factor == 0)
+                continue;
+
+            for (int j = 0; j <= n; j++)
+                system[i * (n + 1) + j] = mod_sub(system[i * (n + 1) + j], mod_mul(factor, system[k * (n + 1) + j], p), p);
+        }
+    }
+
+    for (int j = 0; j < n; j++)
+        weights[j] = system[j * (n + 1) + n];
+
+    free(system);
+}
+
+// Reduced Laplacian without vertex 0 where edge uv weighs t_u t_v, written to one lane of the batch.
+// All entries of the lane are expected to be zero. With t_v <= 64 no reduction modulo p is needed.
+void algebraic_load_lane(LaplacianBatch *batch, Graph *graph, int *points, int lane, uint64_t p)
+{
+    int n = graph->vertices;
+    int size = batch->size;
+    uint64_t *data = batch->data;
+
+    for (int u = 0; u < n; u++)
+    {
+        uint64_t t_u = points[u] + 1;
+
+        for (int v = u + 1; v < n; v++)
+        {
+            if (!(graph->adjacency_matrix[u] & (FIRST_BIT >> v)))
+                continue;
+
+            uint64_t edge_weight = t_u * (points[v] + 1);
+            data[((v - 1) * size + (v - 1)) * KIRCHHOFF_BATCH_SIZE + lane] += edge_weight;
+
+            if (u > 0)
+            {
+                data[((u - 1) * size + (u - 1)) * KIRCHHOFF_BATCH_SIZE + lane] += edge_weight;
+                data[((u - 1) * size + (v - 1)) * KIRCHHOFF_BATCH_SIZE + lane] = p - edge_weight;
+                data[((v - 1) * size + (u - 1)) * KIRCHHOFF_BATCH_SIZE + lane] = p - edge_weight;
+            }
+        }
+    }
+}
+
+// Determinant of one lane with pivoting, for the rare lanes where the batch elimination hits a zero pivot
+uint64_t algebraic_determinant_pivoting(LaplacianBatch *batch, Graph *graph, int *points, uint64_t p)
+{
+    int size = batch->size;
+    uint64_t *matrix = malloc((size * size + 1) * sizeof(uint64_t));
+
+    memset(batch->data, 0, size * size * KIRCHHOFF_BATCH_SIZE * sizeof(uint64_t));
+    algebraic_load_lane(batch, graph, points, 0, p);
+    for (int i = 0; i < size * size; i++)
+        matrix[i] = batch->data[i * KIRCHHOFF_BATCH_SIZE];
+
+    uint64_t determinant = determinant_mod_in_place(matrix, size, p);
+    free(matrix);
+    return determinant;
+}
+
+// Sum over all combinations of points of the product of their weights times the
+// reduced weighted Laplacian determinant, modulo p. Combinations are evaluated in batches.
+uint64_t count_hists_algebraic_mod(LaplacianBatch *batch, Graph *graph, uint64_t p)
+{
+    int n = graph->vertices;
+
+    int degrees[64];
+    uint64_t *weights[64];
+
+    // Weights only depend on the number of points
+    uint64_t *weights_by_degree[64] = {NULL};
+
+    for (int v = 0; v < n; v++)
+    {
+        degrees[v] = vertex_degree(graph->adjacency_matrix[v]);
+
+        if (weights_by_degree[degrees[v]] == NULL)
+        {
+            weights_by_degree[degrees[v]] = malloc(degrees[v] * sizeof(uint64_t));
+            algebraic_weights(degrees[v], p, weights_by_degree[degrees[v]]);
+        }
+
+        weights[v] = weights_by_degree[degrees[v]];
+    }
+
+    int points[64] = {0};
+    int lane_points[KIRCHHOFF_BATCH_SIZE][64];
+    uint64_t lane_weights[KIRCHHOFF_BATCH_SIZE];
+    uint64_t numerators[KIRCHHOFF_BATCH_SIZE];
+    uint64_t denominators[KIRCHHOFF_BATCH_SIZE];
+    bool zero_pivots[KIRCHHOFF_BATCH_SIZE];
+
+    // The sum is kept as a fraction, so only a single inversion is needed at the end
+    uint64_t total_numerator = 0;
+    uint64_t total_denominator = 1;
+    bool exhausted = false;
+    int size = batch->size;
+
+    while (!exhausted)
+    {
+        // Fill the lanes with the next combinations that have a non-zero weight
+        int nb_lanes = 0;
+        memset(batch->data, 0, size * size * KIRCHHOFF_BATCH_SIZE * sizeof(uint64_t));
+
+        while (nb_lanes < KIRCHHOFF_BATCH_SIZE && !exhausted)
+        {
+            // p < 2^31, so products of two residues fit in 64 bits
+            uint64_t weight = 1;
+            for (int v = 0; v < n && weight; v++)
+                weight = weight * weights[v][points[v]] % p;
+
+            if (weight)
+            {
+                memcpy(lane_points[nb_lanes], points, n * sizeof(int));
+                lane_weights[nb_lanes] = weight;
+                algebraic_load_lane(batch, graph, points, nb_lanes, p);
+                nb_lanes++;
+            }
+
+            // Next combination of points, as a mixed radix counter
+            int v = 0;
+            while (v < n && ++points[v] == degrees[v])
+                points[v++] = 0;
+
+            exhausted = v == n;
+        }
+
+        if (nb_lanes == 0)
+            break;
+
+        batch->nb_graphs = nb_lanes;
+        lb_determinants_mod(batch, p, numerators, denominators, zero_pivots);
+
+        for (int lane = 0; lane < nb_lanes; lane++)
+        {
+            if (zero_pivots[lane])
+            {
+                numerators[lane] = algebraic_determinant_pivoting(batch, graph, lane_points[lane], p);
+                denominators[lane] = 1;
+            }
+
+            uint64_t term = lane_weights[lane] * numerators[lane] % p;
+            total_numerator = (total_numerator * denominators[lane] + term * total_denominator) % p;
+            total_denominator = total_denominator * denominators[lane] % p;
+        }
+    }
+
+    for (int d = 0; d < 64; d++)
+        free(weights_by_degree[d]);
+
+    return total_numerator * mod_inverse(total_denominator, p) % p;
+}
+
+bool count_hists_algebraic(Graph *graph, BigNat *count)
+{
+    // A single vertex is a HIST, other graphs need every vertex in the tree
+    if (graph->vertices == 1)
+    {
+        *count = bignat_from_u64(1);
+        return true;
+    }
+
+    unsigned long long int evaluations = algebraic_evaluations(graph);
+
+    if (evaluations == 0)
+    {
+        *count = bignat_from_u64(0);
+        return true;
+    }
+
+    if (evaluations > ALGEBRAIC_MAX_EVALUATIONS)
+        return false;
+
+    // There are at most as many HISTs as spanning trees, all primes are larger than 2^30
+    int nb_primes = spanning_tree_bits(graph) / 30 + 1;
+
+    LaplacianBatch *batch = lb_new(graph->vertices);
+    batch->size = graph->vertices - 1;
+
+    uint64_t residues[NB_MODULAR_PRIMES_31];
+    for (int i = 0; i < nb_primes; i++)
+        residues[i] = count_hists_algebraic_mod(batch, graph, MODULAR_PRIMES_31[i]);
+
+    free_lb(batch);
+
+    *count = bignat_from_residues(residues, MODULAR_PRIMES_31, nb_primes);
+    return true;
+}
@@ -0,0 +1,309 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <hist_blocks.h>
+#include <adjlist.h>
+
+#define BLOCKS_MAX_EDGES (64 * 63 / 2)
+
+/*
+ * Blocks of a connected graph, found with the lowpoint method.
+ * Every block is stored as the bitset of its vertices, the edges of a block are exactly
+ * the edges of the graph between its vertices since two blocks share at most one vertex.
+ */
+typedef struct BlockCutTree
+{
+    Graph *graph;
+    int discovery[64];
+    int low[64];
+    int time;
+    Edge edge_stack[BLOCKS_MAX_EDGES];
+    int stack_size;
+    uint64_t blocks[64];
+    int nb_blocks;
+} BlockCutTree;
+
+void blocks_visit(BlockCutTree *tree, int vertex, int parent)
+{
+    tree->discovery[vertex] = tree->low[vertex] = tree->time++;
+
+    for (uint64_t rest = tree->graph->adjacency_matrix[vertex]; rest; rest &= ~(FIRST_BIT >> first_bit_position(rest)))
+    {
+        int neighbour = first_bit_position(rest);
+
+        if (tree->discovery[neighbour] < 0)
+        {
+            tree->edge_stack[tree->stack_size++] = (Edge){vertex, neighbour};
+            blocks_visit(tree, neighbour, vertex);
+
+            if (tree->low[neighbour] < tree->low[vertex])
+                tree->low[vertex] = tree->low[neighbour];
+
+            // Vertex separates the subtree of neighbour, the edges on the stack above it form a block
+            if (tree->low[neighbour] >= tree->discovery[vertex])
+            {
+                uint64_t block = 0;
+                Edge popped;
+                do
+                {
+                    popped = tree->edge_stack[--tree->stack_size];
+                    block |= (FIRST_BIT >> popped.origin) | (FIRST_BIT >> popped.destination);
+                } while (popped.origin != vertex || popped.destination != neighbour);
+
+                tree->blocks[tree->nb_blocks++] = block;
+            }
+        }
+        else if (neighbour != parent && tree->discovery[neighbour] < tree->discovery[vertex])
+        {
+            tree->edge_stack[tree->stack_size++] = (Edge){vertex, neighbour};
+
+            if (tree->discovery[neighbour] < tree->low[vertex])
+                tree->low[vertex] = tree->discovery[neighbour];
+        }
+    }
+}
+
+// Number of HISTs of the block in which every shared cut vertex has tree degree 1 or at least 2 as given by
+// the mask. The search can not leave vertices unconstrained, so cut vertices are padded with leaves instead:
+// a vertex with one extra leaf has tree degree 2 only if it had 1 before, with two extra leaves never.
+// Counting with one leaf on the vertices in the mask forces them to at least 2 and leaves the others free,
+// the exact table follows by inclusion-exclusion over supersets.
+bool block_hist_table(AdjListWorkspace *workspace, Graph *graph, uint64_t block, int *shared, int nb_shared, uint64_t cut_vertices, uint64_t *table)
+{
+    int labels[64];
+    int nb_vertices = 0;
+
+    for (uint64_t rest = block; rest; rest &= ~(FIRST_BIT >> first_bit_position(rest)))
+        labels[first_bit_position(rest)] = nb_vertices++;
+
+    int nb_cut_vertices = count_set_bits(block & cut_vertices);
+    if (nb_vertices + 2 * nb_cut_vertices > 64)
+        return false;
+
+    for (int mask = 0; mask < (1 << nb_shared); mask++)
+    {
+        uint64_t forced = 0;
+        for (int i = 0; i < nb_shared; i++)
+        {
+            if (mask & (1 << i))
+                forced |= FIRST_BIT >> shared[i];
+        }
+
+        Graph *padded = empty_graph(nb_vertices + 2 * nb_cut_vertices - count_set_bits(forced));
+        int next_leaf = nb_vertices;
+
+        for (uint64_t rest = block; rest; rest &= ~(FIRST_BIT >> first_bit_position(rest)))
+        {
+            int vertex = first_bit_position(rest);
+
+            for (uint64_t neighbours = graph->adjacency_matrix[vertex] & block; neighbours; neighbours &= ~(FIRST_BIT >> first_bit_position(neighbours)))
+            {
+                int neighbour = first_bit_position(neighbours);
+                if (neighbour > vertex)
+                    add_edge_to_graph(padded, &(Edge){labels[vertex], labels[neighbour]});
+            }
+
+            if (!((FIRST_BIT >> vertex) & cut_vertices))
+                continue;
+
+            int nb_leaves = (FIRST_BIT >> vertex) & forced ? 1 : 2;
+            for (int leaf = 0; leaf < nb_leaves; leaf++)
+                add_edge_to_graph(padded, &(Edge){labels[vertex], next_leaf++});
+        }
+
+        RunData run_data;
+        find_hists_alg_ws(workspace, padded, 0, hist_default_branching, NULL, false, &run_data);
+        table[mask] = run_data.hists_this_run;
+        free_graph(padded);
+    }
+
+    // The counts are exact, so wrapping around in between is harmless
+    for (int i = 0; i < nb_shared; i++)
+    {
+        for (int mask = 0; mask < (1 << nb_shared); mask++)
+        {
+            if (!(mask & (1 << i)))
+                table[mask] -= table[mask | (1 << i)];
+        }
+    }
+
+    return true;
+}
+
+bool count_hists_blocks(Graph *graph, BigNat *count)
+{
+    int n = graph->vertices;
+    if (n < 3)
+        return false;
+
+    BlockCutTree *tree = malloc(sizeof(BlockCutTree));
+    if (tree == NULL)
+    {
+        fprintf(stderr, "Failed to allocate block-cut tree.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    tree->graph = graph;
+    tree->time = 0;
+    tree->stack_size = 0;
+    tree->nb_blocks = 0;
+    for (int v = 0; v < n; v++)
+        tree->discovery[v] = -1;
+
+    blocks_visit(tree, 0, -1);
+
+    if (tree->time < n)
+    {
+        free(tree);
+        *count = bignat_from_u64(0);
+        return true;
+    }
+
+    int nb_blocks = tree->nb_blocks;
+    uint64_t *blocks = tree->blocks;
+    int memberships[64] = {0};
+    uint64_t cut_vertices = 0;
+
+    for (int b = 0; b < nb_blocks; b++)
+    {
+        for (int v = 0; v < n; v++)
+            memberships[v] += (blocks[b] & (FIRST_BIT >> v)) != 0;
+    }
+
+    for (int v = 0; v < n; v++)
+    {
+        if (memberships[v] > 1)
+            cut_vertices |= FIRST_BIT >> v;
+    }
+
+    if (cut_vertices == 0)
+    {
+        free(tree);
+        return false;
+    }
+
+    // Blocks in breadth first order of the block-cut tree, rooted at the first block
+    int order[64];
+    int parent_cut[64];
+    bool visited[64] = {false};
+    int nb_ordered = 0;
+
+    order[nb_ordered++] = 0;
+    parent_cut[0] = -1;
+    visited[0] = true;
+
+    for (int head = 0; head < nb_ordered; head++)
+    {
+        int b = order[head];
+        for (uint64_t rest = blocks[b] & cut_vertices; rest; rest &= ~(FIRST_BIT >> first_bit_position(rest)))
+        {
+            int cut = first_bit_position(rest);
+            for (int child = 0; child < nb_blocks; child++)
+            {
+                if (visited[child] || !(blocks[child] & (FIRST_BIT >> cut)))
+                    continue;
+
+                visited[child] = true;
+                parent_cut[child] = cut;
+                order[nb_ordered++] = child;
+            }
+        }
+    }
+
+    // Counts of the subtree below every block with tree degree 1 and at least 2 at its parent cut vertex.
+    // Blocks without a parent shared with a single other block only use the second.
+    BigNat values[64][2];
+    AdjListWorkspace *workspace = alw_new();
+    uint64_t *table = malloc((1 << BLOCKS_MAX_SHARED) * sizeof(uint64_t));
+    bool counted = true;
+
+    for (int i = nb_ordered - 1; i >= 0 && counted; i--)
+    {
+        int b = order[i];
+        int shared[64];
+        int nb_shared = 0;
+        int parent_index = -1;
+        BigNat factor = bignat_from_u64(1);
+
+        // Shared cut vertices are resolved per entry of the table, the others multiply every entry
+        BigNat with_one[64];
+        BigNat with_more[64];
+
+        for (uint64_t rest = blocks[b] & cut_vertices; rest; rest &= ~(FIRST_BIT >> first_bit_position(rest)))
+        {
+            int cut = first_bit_position(rest);
+
+            if (memberships[cut] == 2)
+            {
+                if (cut == parent_cut[b])
+                    parent_index = nb_shared;
+                else
+                {
+                    // Tree degree 1 here needs at least 2 in the child block
+                    for (int child = 0; child < nb_blocks; child++)
+                    {
+                        if (child == b || parent_cut[child] != cut || !(blocks[child] & (FIRST_BIT >> cut)))
+                            continue;
+
+                        with_one[nb_shared] = values[child][1];
+                        with_more[nb_shared] = values[child][0];
+                        bignat_add(&with_more[nb_shared], &values[child][1]);
+                    }
+                }
+
+                shared[nb_shared++] = cut;
+            }
+            else if (cut != parent_cut[b])
+            {
+                for (int child = 0; child < nb_blocks; child++)
+                {
+                    if (child == b || parent_cut[child] != cut || !(blocks[child] & (FIRST_BIT >> cut)))
+                        continue;
+
+                    BigNat total = values[child][0];
+                    bignat_add(&total, &values[child][1]);
+                    bignat_mul(&factor, &total);
+                }
+            }
+        }
+
+        if (nb_shared > BLOCKS_MAX_SHARED || !block_hist_table(workspace, graph, blocks[b], shared, nb_shared, cut_vertices, table))
+        {
+            counted = false;
+            break;
+        }
+
+        values[b][0] = bignat_from_u64(0);
+        values[b][1] = bignat_from_u64(0);
+
+        for (int mask = 0; mask < (1 << nb_shared); mask++)
+        {
+            if (table[mask] == 0)
+                continue;
+
+            BigNat term = bignat_from_u64(table[mask]);
+            for (int j = 0; j < nb_shared; j++)
+            {
+                if (j != parent_index)
+                    bignat_mul(&term, mask & (1 << j) ? &with_more[j] : &with_one[j]);
+            }
+
+            int side = parent_index >= 0 && !(mask & (1 << parent_index)) ? 0 : 1;
+            bignat_add(&values[b][side], &term);
+        }
+
+        bignat_mul(&values[b][0], &factor);
+        bignat_mul(&values[b][1], &factor);
+    }
+
+    if (counted)
+    {
+        *count = values[0][0];
+        bignat_add(count, &values[0][1]);
+    }
+
+    free(table);
+    free_alw(workspace);
+    free(tree);
+    return counted;
+}
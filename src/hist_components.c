@@ -0,0 +1,655 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <hist_components.h>
+#include <kirchhoff.h>
+#include <modular.h>
+#include <hist_zdd.h>
+
+// Remembered count of a residual part, the key is stored in the key pool
+typedef struct ComponentCacheEntry
+{
+    uint64_t hash;
+    size_t key_offset;
+    BigNat count;
+} ComponentCacheEntry;
+
+typedef struct ComponentContext
+{
+    int nb_edges;
+    // Number of 64 bit words in an edge set
+    int words;
+    Edge *edges;
+    // Edges incident to vertex v are incident[incident_offsets[v]] up to incident[incident_offsets[v + 1]]
+    int incident_offsets[65];
+    int *incident;
+
+    // Open addressing on hashes of the keys, -1 marks an empty slot
+    int *slots;
+    ComponentCacheEntry *entries;
+    int nb_entries;
+    // Keys: the edge words of a part followed by one byte per vertex
+    uint8_t *key_pool;
+    size_t key_pool_size;
+    size_t key_pool_capacity;
+} ComponentContext;
+
+// Partial forest of the chosen edges: a component label and the tree degree capped at 3 per vertex
+typedef struct ComponentForest
+{
+    uint8_t components[64];
+    uint8_t degrees[64];
+} ComponentForest;
+
+#define COMPONENT_KEY_SIZE(context) ((context)->words * sizeof(uint64_t) + 64)
+
+bool edge_in_set(uint64_t *set, int edge)
+{
+    return set[edge >> 6] & (1ULL << (edge & 63));
+}
+
+void remove_from_edge_set(uint64_t *set, int edge)
+{
+    set[edge >> 6] &= ~(1ULL << (edge & 63));
+}
+
+// Key of a part: its undecided edges and for every vertex of the part its degree and its component, numbered in
+// order of first appearance. Vertices outside the part are marked with 0xff.
+void component_key(ComponentContext *context, ComponentForest *forest, uint64_t *part_edges, uint64_t part_vertices, uint8_t *key)
+{
+    memcpy(key, part_edges, context->words * sizeof(uint64_t));
+    uint8_t *vertex_bytes = key + context->words * sizeof(uint64_t);
+
+    int mapping[64];
+    memset(mapping, -1, sizeof(mapping));
+    int next_label = 0;
+
+    for (int v = 0; v < 64; v++)
+    {
+        if (!(part_vertices & (FIRST_BIT >> v)))
+        {
+            vertex_bytes[v] = 0xff;
+            continue;
+        }
+
+        int component = forest->components[v];
+        if (mapping[component] < 0)
+            mapping[component] = next_label++;
+
+        vertex_bytes[v] = (mapping[component] << 2) | forest->degrees[v];
+    }
+}
+
+uint64_t component_hash(const uint8_t *key, size_t size)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < size; i++)
+        hash = (hash ^ key[i]) * 0x100000001b3ULL;
+
+    return hash ^ (hash >> 32);
+}
+
+int component_cache_slot(ComponentContext *context, const uint8_t *key, uint64_t hash)
+{
+    size_t key_size = COMPONENT_KEY_SIZE(context);
+    int mask = 2 * COMPONENT_CACHE_SIZE - 1;
+    int slot = hash & mask;
+
+    while (context->slots[slot] >= 0)
+    {
+        ComponentCacheEntry *entry = &context->entries[context->slots[slot]];
+        if (entry->hash == hash && memcmp(&context->key_pool[entry->key_offset], key, key_size) == 0)
+            break;
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
+
+void component_cache_store(ComponentContext *context, const uint8_t *key, uint64_t hash, BigNat *count)
+{
+    size_t key_size = COMPONENT_KEY_SIZE(context);
+
+    // Once the cache is full the search continues without remembering more parts
+    if (context->nb_entries == COMPONENT_CACHE_SIZE)
+        return;
+
+    if (context->key_pool_size + key_size > context->key_pool_capacity)
+    {
+        context->key_pool_capacity = 2 * context->key_pool_capacity + key_size;
+        context->key_pool = realloc(context->key_pool, context->key_pool_capacity);
+
+        if (context->key_pool == NULL)
+        {
+            fprintf(stderr, "Failed to grow component cache.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    int slot = component_cache_slot(context, key, hash);
+    ComponentCacheEntry *entry = &context->entries[context->nb_entries];
+    entry->hash = hash;
+    entry->key_offset = context->key_pool_size;
+    entry->count = *count;
+
+    memcpy(&context->key_pool[context->key_pool_size], key, key_size);
+    context->key_pool_size += key_size;
+    context->slots[slot] = context->nb_entries++;
+}
+
+// Number of spanning trees of the multigraph on the components, where every edge of the part joins two of them
+BigNat component_spanning_trees(ComponentContext *context, uint64_t *part_edges, int *node_of_component, int nb_nodes)
+{
+    int size = nb_nodes - 1;
+    // Node 0 is left out of the reduced Laplacian
+    long long int *entries = calloc(size * size + 1, sizeof(long long int));
+    uint64_t *data = malloc((size * size + 1) * sizeof(uint64_t));
+    int degrees[64] = {0};
+
+    if (entries == NULL || data == NULL)
+    {
+        fprintf(stderr, "Failed to allocate component Laplacian.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int word = 0; word < context->words; word++)
+    {
+        for (uint64_t rest = part_edges[word]; rest; rest &= rest - 1)
+        {
+            Edge *edge = &context->edges[64 * word + __builtin_ctzll(rest)];
+            int a = node_of_component[edge->origin];
+            int b = node_of_component[edge->destination];
+
+            degrees[a]++;
+            degrees[b]++;
+
+            if (a > 0)
+                entries[(a - 1) * size + (a - 1)]++;
+            if (b > 0)
+                entries[(b - 1) * size + (b - 1)]++;
+            if (a > 0 && b > 0)
+            {
+                entries[(a - 1) * size + (b - 1)]--;
+                entries[(b - 1) * size + (a - 1)]--;
+            }
+        }
+    }
+
+    // The product of the degrees bounds the count, and so does the count of the simple graph on at most 64 vertices
+    int bits = 1;
+    for (int node = 1; node < nb_nodes; node++)
+    {
+        for (int degree = degrees[node]; degree; degree >>= 1)
+            bits++;
+    }
+
+    if (bits > 6 * 62 + 1)
+        bits = 6 * 62 + 1;
+
+    int nb_primes = bits / 61 + 1;
+    uint64_t residues[NB_MODULAR_PRIMES];
+
+    for (int i = 0; i < nb_primes; i++)
+    {
+        for (int j = 0; j < size * size; j++)
+            data[j] = mod_from_signed(entries[j], MODULAR_PRIMES[i]);
+
+        residues[i] = determinant_mod_in_place(data, size, MODULAR_PRIMES[i]);
+    }
+
+    free(entries);
+    free(data);
+    return bignat_from_residues(residues, MODULAR_PRIMES, nb_primes);
+}
+
+/*
+ * Blocks of the multigraph on the components, found with the lowpoint method.
+ * Parallel edges are told apart by their index, so two nodes joined by two edges form a block.
+ */
+typedef struct ComponentBlocks
+{
+    ComponentContext *context;
+    uint64_t *part_edges;
+    int *node_of_component;
+    // Edges of the part incident to every node
+    int node_offsets[65];
+    int *node_edges;
+    int discovery[64];
+    int low[64];
+    int time;
+    int *edge_stack;
+    int stack_size;
+    // Block of every edge, -1 while not assigned
+    int *edge_blocks;
+    int nb_blocks;
+} ComponentBlocks;
+
+void component_blocks_visit(ComponentBlocks *blocks, int node, int parent_edge)
+{
+    blocks->discovery[node] = blocks->low[node] = blocks->time++;
+
+    for (int i = blocks->node_offsets[node]; i < blocks->node_offsets[node + 1]; i++)
+    {
+        int e = blocks->node_edges[i];
+        if (e == parent_edge)
+            continue;
+
+        Edge *edge = &blocks->context->edges[e];
+        int a = blocks->node_of_component[edge->origin];
+        int other = a == node ? blocks->node_of_component[edge->destination] : a;
+
+        if (blocks->discovery[other] < 0)
+        {
+            blocks->edge_stack[blocks->stack_size++] = e;
+            component_blocks_visit(blocks, other, e);
+
+            if (blocks->low[other] < blocks->low[node])
+                blocks->low[node] = blocks->low[other];
+
+            // Node separates the subtree of other, its edges form a block
+            if (blocks->low[other] >= blocks->discovery[node])
+            {
+                int popped;
+                do
+                {
+                    popped = blocks->edge_stack[--blocks->stack_size];
+                    blocks->edge_blocks[popped] = blocks->nb_blocks;
+                } while (popped != e);
+
+                blocks->nb_blocks++;
+            }
+        }
+        else if (blocks->discovery[other] < blocks->discovery[node])
+        {
+            blocks->edge_stack[blocks->stack_size++] = e;
+
+            if (blocks->discovery[other] < blocks->low[node])
+                blocks->low[node] = blocks->discovery[other];
+        }
+    }
+}
+
+int component_find(int *parents, int x)
+{
+    while (parents[x] != x)
+        x = parents[x] = parents[parents[x]];
+
+    return x;
+}
+
+BigNat component_count_part(ComponentContext *context, ComponentForest *forest, uint64_t *part_edges, uint64_t part_vertices);
+
+// Branches on the first undecided edge of a part that can not be split
+BigNat component_branch(ComponentContext *context, ComponentForest *forest, uint64_t *part_edges, uint64_t part_vertices)
+{
+    int branch_edge = -1;
+    for (int word = 0; word < context->words && branch_edge < 0; word++)
+    {
+        if (part_edges[word])
+            branch_edge = 64 * word + __builtin_ctzll(part_edges[word]);
+    }
+
+    uint64_t *remaining = malloc(context->words * sizeof(uint64_t));
+    memcpy(remaining, part_edges, context->words * sizeof(uint64_t));
+    remove_from_edge_set(remaining, branch_edge);
+
+    BigNat count = component_count_part(context, forest, remaining, part_vertices);
+
+    // The components differ, edges inside a component have been left out before branching
+    Edge *edge = &context->edges[branch_edge];
+    ComponentForest with_edge = *forest;
+    int kept = with_edge.components[edge->origin];
+    int merged = with_edge.components[edge->destination];
+
+    for (int v = 0; v < 64; v++)
+    {
+        if (with_edge.components[v] == merged)
+            with_edge.components[v] = kept;
+    }
+
+    if (with_edge.degrees[edge->origin] < 3)
+        with_edge.degrees[edge->origin]++;
+    if (with_edge.degrees[edge->destination] < 3)
+        with_edge.degrees[edge->destination]++;
+
+    BigNat count_with_edge = component_count_part(context, &with_edge, remaining, part_vertices);
+    bignat_add(&count, &count_with_edge);
+
+    free(remaining);
+    return count;
+}
+
+// Number of ways to pick edges of the part that join all components of its vertices into a tree,
+// such that none of its vertices whose undecided edges all lie in the part ends up with tree degree 2
+BigNat component_count_part(ComponentContext *context, ComponentForest *forest, uint64_t *part_edges, uint64_t part_vertices)
+{
+    int words = context->words;
+    uint64_t *edges = malloc(words * sizeof(uint64_t));
+    memcpy(edges, part_edges, words * sizeof(uint64_t));
+
+    int undecided_degrees[64] = {0};
+    int nb_part_edges = 0;
+
+    // Edges within a component would close a cycle
+    for (int word = 0; word < words; word++)
+    {
+        for (uint64_t rest = edges[word]; rest; rest &= rest - 1)
+        {
+            int e = 64 * word + __builtin_ctzll(rest);
+            Edge *edge = &context->edges[e];
+
+            if (forest->components[edge->origin] == forest->components[edge->destination])
+            {
+                remove_from_edge_set(edges, e);
+                continue;
+            }
+
+            undecided_degrees[edge->origin]++;
+            undecided_degrees[edge->destination]++;
+            nb_part_edges++;
+        }
+    }
+
+    // Vertices of the part without undecided edges have their final tree degree
+    BigNat zero = bignat_from_u64(0);
+    uint64_t live_vertices = 0;
+    uint64_t labels = 0;
+    uint64_t live_labels = 0;
+    bool constrained = false;
+
+    for (int v = 0; v < 64; v++)
+    {
+        if (!(part_vertices & (FIRST_BIT >> v)))
+            continue;
+
+        if (undecided_degrees[v] == 0 && (forest->degrees[v] == 0 || forest->degrees[v] == 2))
+        {
+            free(edges);
+            return zero;
+        }
+
+        labels |= 1ULL << forest->components[v];
+        if (undecided_degrees[v] == 0)
+            continue;
+
+        live_vertices |= FIRST_BIT >> v;
+        live_labels |= 1ULL << forest->components[v];
+
+        if (forest->degrees[v] < 3)
+            constrained = true;
+    }
+
+    if (nb_part_edges == 0)
+    {
+        free(edges);
+        return bignat_from_u64(__builtin_popcountll(labels) == 1);
+    }
+
+    // A component without undecided edges can not be joined to the others anymore.
+    // Otherwise only the vertices with undecided edges matter from here on.
+    if (labels != live_labels)
+    {
+        free(edges);
+        return zero;
+    }
+
+    part_vertices = live_vertices;
+
+    // Node of every vertex, so edges can be mapped directly
+    int node_of_label[64];
+    int node_of_component[64];
+    int nb_nodes = 0;
+
+    memset(node_of_label, -1, sizeof(node_of_label));
+    for (int v = 0; v < 64; v++)
+    {
+        node_of_component[v] = -1;
+        if (!(part_vertices & (FIRST_BIT >> v)))
+            continue;
+
+        if (node_of_label[forest->components[v]] < 0)
+            node_of_label[forest->components[v]] = nb_nodes++;
+        node_of_component[v] = node_of_label[forest->components[v]];
+    }
+
+    uint8_t *key = malloc(COMPONENT_KEY_SIZE(context));
+    component_key(context, forest, edges, part_vertices, key);
+    uint64_t hash = component_hash(key, COMPONENT_KEY_SIZE(context));
+    int slot = component_cache_slot(context, key, hash);
+
+    if (context->slots[slot] >= 0)
+    {
+        BigNat count = context->entries[context->slots[slot]].count;
+        free(key);
+        free(edges);
+        return count;
+    }
+
+    BigNat count;
+
+    if (!constrained)
+    {
+        // Every vertex already has tree degree 3 or more, any spanning tree of the components will do
+        count = component_spanning_trees(context, edges, node_of_component, nb_nodes);
+    }
+    else
+    {
+        ComponentBlocks blocks;
+        blocks.context = context;
+        blocks.part_edges = edges;
+        blocks.node_of_component = node_of_component;
+        blocks.node_edges = malloc(2 * nb_part_edges * sizeof(int));
+        blocks.edge_stack = malloc(nb_part_edges * sizeof(int));
+        blocks.edge_blocks = malloc(context->nb_edges * sizeof(int));
+        blocks.time = 0;
+        blocks.stack_size = 0;
+        blocks.nb_blocks = 0;
+
+        memset(blocks.node_offsets, 0, sizeof(blocks.node_offsets));
+        for (int word = 0; word < words; word++)
+        {
+            for (uint64_t rest = edges[word]; rest; rest &= rest - 1)
+            {
+                Edge *edge = &context->edges[64 * word + __builtin_ctzll(rest)];
+                blocks.node_offsets[node_of_component[edge->origin] + 1]++;
+                blocks.node_offsets[node_of_component[edge->destination] + 1]++;
+            }
+        }
+
+        for (int node = 0; node < nb_nodes; node++)
+            blocks.node_offsets[node + 1] += blocks.node_offsets[node];
+
+        int fill[64];
+        memcpy(fill, blocks.node_offsets, sizeof(fill));
+        for (int word = 0; word < words; word++)
+        {
+            for (uint64_t rest = edges[word]; rest; rest &= rest - 1)
+            {
+                int e = 64 * word + __builtin_ctzll(rest);
+                Edge *edge = &context->edges[e];
+                blocks.node_edges[fill[node_of_component[edge->origin]]++] = e;
+                blocks.node_edges[fill[node_of_component[edge->destination]]++] = e;
+            }
+        }
+
+        for (int node = 0; node < nb_nodes; node++)
+            blocks.discovery[node] = -1;
+
+        component_blocks_visit(&blocks, 0, -1);
+
+        bool connected = true;
+        for (int node = 0; node < nb_nodes; node++)
+            connected = connected && blocks.discovery[node] >= 0;
+
+        // Blocks sharing a vertex that can still get tree degree 2 have to be counted together
+        int *parents = malloc((blocks.nb_blocks + 1) * sizeof(int));
+        for (int block = 0; block < blocks.nb_blocks; block++)
+            parents[block] = block;
+
+        for (int v = 0; v < 64 && connected; v++)
+        {
+            if (undecided_degrees[v] == 0 || forest->degrees[v] >= 3)
+                continue;
+
+            int first_block = -1;
+            for (int i = context->incident_offsets[v]; i < context->incident_offsets[v + 1]; i++)
+            {
+                int e = context->incident[i];
+                if (!edge_in_set(edges, e))
+                    continue;
+
+                int block = component_find(parents, blocks.edge_blocks[e]);
+                if (first_block < 0)
+                    first_block = block;
+                else if (block != first_block)
+                    parents[block] = first_block;
+            }
+        }
+
+        int nb_groups = 0;
+        for (int block = 0; block < blocks.nb_blocks; block++)
+            nb_groups += component_find(parents, block) == block;
+
+        if (!connected)
+        {
+            count = zero;
+        }
+        else if (nb_groups == 1)
+        {
+            count = component_branch(context, forest, edges, part_vertices);
+        }
+        else
+        {
+            count = bignat_from_u64(1);
+            uint64_t *group_edges = malloc(words * sizeof(uint64_t));
+
+            for (int group = 0; group < blocks.nb_blocks && !bignat_is_zero(&count); group++)
+            {
+                if (component_find(parents, group) != group)
+                    continue;
+
+                memset(group_edges, 0, words * sizeof(uint64_t));
+                uint64_t group_vertices = 0;
+
+                for (int word = 0; word < words; word++)
+                {
+                    for (uint64_t rest = edges[word]; rest; rest &= rest - 1)
+                    {
+                        int e = 64 * word + __builtin_ctzll(rest);
+                        if (component_find(parents, blocks.edge_blocks[e]) != group)
+                            continue;
+
+                        group_edges[word] |= 1ULL << (e & 63);
+                        group_vertices |= (FIRST_BIT >> context->edges[e].origin) | (FIRST_BIT >> context->edges[e].destination);
+                    }
+                }
+
+                BigNat group_count = component_count_part(context, forest, group_edges, group_vertices);
+                bignat_mul(&count, &group_count);
+            }
+
+            free(group_edges);
+        }
+
+        free(parents);
+        free(blocks.node_edges);
+        free(blocks.edge_stack);
+        free(blocks.edge_blocks);
+    }
+
+    // The slot may have moved while counting the subparts
+    component_cache_store(context, key, hash, &count);
+
+    free(key);
+    free(edges);
+    return count;
+}
+
+BigNat count_hists_components_alg(AdjListGraph *graph)
+{
+    // A single vertex is a HIST, other graphs need every vertex in the tree
+    if (graph->nb_available_vertices <= 1)
+        return bignat_from_u64(graph->nb_available_vertices == 1);
+
+    ComponentContext context;
+    context.edges = malloc((graph->edges->size + 1) * sizeof(Edge));
+    context.incident = malloc((2 * graph->edges->size + 1) * sizeof(int));
+
+    if (context.edges == NULL || context.incident == NULL)
+    {
+        fprintf(stderr, "Failed to allocate component context.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // Branching on the edges in the order of the ZDD builder keeps the undecided parts narrow
+    context.nb_edges = zdd_edge_order(graph, context.edges);
+    if (context.nb_edges < 0)
+    {
+        free(context.edges);
+        free(context.incident);
+        return bignat_from_u64(0);
+    }
+
+    memset(context.incident_offsets, 0, sizeof(context.incident_offsets));
+    for (int e = 0; e < context.nb_edges; e++)
+    {
+        context.incident_offsets[context.edges[e].origin + 1]++;
+        context.incident_offsets[context.edges[e].destination + 1]++;
+    }
+
+    for (int v = 0; v < 64; v++)
+        context.incident_offsets[v + 1] += context.incident_offsets[v];
+
+    int fill[64];
+    memcpy(fill, context.incident_offsets, sizeof(fill));
+    for (int e = 0; e < context.nb_edges; e++)
+    {
+        context.incident[fill[context.edges[e].origin]++] = e;
+        context.incident[fill[context.edges[e].destination]++] = e;
+    }
+
+    context.words = context.nb_edges / 64 + 1;
+    context.slots = malloc(2 * COMPONENT_CACHE_SIZE * sizeof(int));
+    context.entries = malloc(COMPONENT_CACHE_SIZE * sizeof(ComponentCacheEntry));
+    context.nb_entries = 0;
+    context.key_pool = NULL;
+    context.key_pool_size = 0;
+    context.key_pool_capacity = 0;
+
+    if (context.slots == NULL || context.entries == NULL)
+    {
+        fprintf(stderr, "Failed to allocate component cache.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    memset(context.slots, -1, 2 * COMPONENT_CACHE_SIZE * sizeof(int));
+
+    ComponentForest forest;
+    for (int v = 0; v < 64; v++)
+    {
+        forest.components[v] = v;
+        forest.degrees[v] = 0;
+    }
+
+    uint64_t *all_edges = calloc(context.words, sizeof(uint64_t));
+    for (int e = 0; e < context.nb_edges; e++)
+        all_edges[e >> 6] |= 1ULL << (e & 63);
+
+    BigNat count = component_count_part(&context, &forest, all_edges, graph->available_vertices);
+
+    free(all_edges);
+    free(context.edges);
+    free(context.incident);
+    free(context.slots);
+    free(context.entries);
+    free(context.key_pool);
+    return count;
+}
+
+bool count_hists_components(Graph *graph, BigNat *count)
+{
+    AdjListGraph *alg = alg_from_graph_and_hidden(graph, 0);
+    *count = count_hists_components_alg(alg);
+    free_alg(alg);
+    return true;
+}
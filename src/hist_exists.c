@@ -0,0 +1,417 @@
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include <hist_exists.h>
+#include <adjlist.h>
+
+uint64_t exists_random(uint64_t *seed)
+{
+    // splitmix64
+    uint64_t z = (*seed += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// Spanning tree of the available vertices grown from the root. Every step expands the tree vertex with the
+// most neighbours outside the tree and takes all of them, which keeps the inner vertices at high degree.
+// Returns false if the available vertices are not connected.
+bool exists_greedy_tree(Graph *graph, uint64_t available, unsigned int root, uint64_t *tree)
+{
+    uint64_t reached = FIRST_BIT >> root;
+    uint64_t open = reached;
+
+    memset(tree, 0, graph->vertices * sizeof(uint64_t));
+
+    while (open)
+    {
+        unsigned int best = first_bit_position(open);
+        unsigned int best_count = 0;
+
+        for (uint64_t rest = open; rest; rest &= ~(FIRST_BIT >> first_bit_position(rest)))
+        {
+            unsigned int vertex = first_bit_position(rest);
+            unsigned int count = count_set_bits(graph->adjacency_matrix[vertex] & available & ~reached);
+
+            if (count > best_count)
+            {
+                best = vertex;
+                best_count = count;
+            }
+        }
+
+        uint64_t children = graph->adjacency_matrix[best] & available & ~reached;
+        open &= ~(FIRST_BIT >> best);
+
+        for (uint64_t rest = children; rest; rest &= ~(FIRST_BIT >> first_bit_position(rest)))
+        {
+            unsigned int child = first_bit_position(rest);
+            tree[best] |= FIRST_BIT >> child;
+            tree[child] |= FIRST_BIT >> best;
+        }
+
+        reached |= children;
+        open |= children;
+    }
+
+    return reached == available;
+}
+
+uint64_t exists_degree_two(uint64_t *tree, uint64_t available)
+{
+    uint64_t degree_two = 0;
+
+    for (uint64_t rest = available; rest; rest &= ~(FIRST_BIT >> first_bit_position(rest)))
+    {
+        unsigned int vertex = first_bit_position(rest);
+        if (vertex_degree(tree[vertex]) == 2)
+            degree_two |= FIRST_BIT >> vertex;
+    }
+
+    return degree_two;
+}
+
+// Change in the number of vertices of tree degree 2 when the first edge is added and the second removed
+int exists_swap_change(int *degrees, unsigned int add_origin, unsigned int add_destination, unsigned int remove_origin, unsigned int remove_destination)
+{
+    unsigned int touched[4] = {add_origin, add_destination, remove_origin, remove_destination};
+    uint64_t seen = 0;
+    int before = 0;
+    int after = 0;
+
+    for (int i = 0; i < 4; i++)
+    {
+        if (seen & (FIRST_BIT >> touched[i]))
+            continue;
+
+        seen |= FIRST_BIT >> touched[i];
+        before += degrees[touched[i]] == 2;
+    }
+
+    degrees[add_origin]++;
+    degrees[add_destination]++;
+    degrees[remove_origin]--;
+    degrees[remove_destination]--;
+
+    for (uint64_t rest = seen; rest; rest &= ~(FIRST_BIT >> first_bit_position(rest)))
+        after += degrees[first_bit_position(rest)] == 2;
+
+    degrees[add_origin]--;
+    degrees[add_destination]--;
+    degrees[remove_origin]++;
+    degrees[remove_destination]++;
+
+    return after - before;
+}
+
+typedef struct ExistsSwap
+{
+    Edge added;
+    Edge removed;
+    int change;
+    unsigned int nb_ties;
+} ExistsSwap;
+
+void exists_consider_swap(ExistsSwap *best, int *degrees, Edge added, Edge removed, uint64_t *seed)
+{
+    int change = exists_swap_change(degrees, added.origin, added.destination, removed.origin, removed.destination);
+
+    if (change > best->change)
+        return;
+
+    if (change < best->change)
+        best->nb_ties = 0;
+
+    // Reservoir sampling among the best swaps, so repeated repairs don't keep undoing each other
+    best->nb_ties++;
+    if (exists_random(seed) % best->nb_ties == 0)
+    {
+        best->added = added;
+        best->removed = removed;
+        best->change = change;
+    }
+}
+
+// Swaps one edge of the tree so the vertex gets tree degree 3 or 1, choosing the swap that leaves the fewest
+// vertices of tree degree 2. A new edge at the vertex closes a cycle through one of its branches, any edge
+// of that cycle away from the vertex can go. Dropping an edge at the vertex splits off its branch,
+// any edge from that branch to the rest of the tree except the vertex reconnects it.
+// Returns false if the vertex has no such swap.
+bool exists_repair_vertex(Graph *graph, uint64_t available, uint64_t *tree, unsigned int vertex, uint64_t *seed)
+{
+    unsigned int parents[64];
+    unsigned int queue[64];
+    uint64_t branches[64];
+    int degrees[64];
+    unsigned int head = 0;
+    unsigned int tail = 0;
+    uint64_t vertex_bit = FIRST_BIT >> vertex;
+
+    for (uint64_t rest = available; rest; rest &= ~(FIRST_BIT >> first_bit_position(rest)))
+    {
+        unsigned int other = first_bit_position(rest);
+        degrees[other] = vertex_degree(tree[other]);
+    }
+
+    // Tree rooted at the vertex, every child of the vertex gets the bitset of its branch
+    uint64_t reached = vertex_bit;
+    for (uint64_t rest = tree[vertex]; rest; rest &= ~(FIRST_BIT >> first_bit_position(rest)))
+    {
+        unsigned int child = first_bit_position(rest);
+        parents[child] = vertex;
+        branches[child] = FIRST_BIT >> child;
+        reached |= FIRST_BIT >> child;
+        queue[tail++] = child;
+    }
+
+    unsigned int branch_of[64];
+    for (unsigned int i = 0; i < tail; i++)
+        branch_of[queue[i]] = queue[i];
+
+    while (head < tail)
+    {
+        unsigned int current = queue[head++];
+
+        for (uint64_t rest = tree[current] & ~reached; rest; rest &= ~(FIRST_BIT >> first_bit_position(rest)))
+        {
+            unsigned int child = first_bit_position(rest);
+            parents[child] = current;
+            branch_of[child] = branch_of[current];
+            branches[branch_of[current]] |= FIRST_BIT >> child;
+            reached |= FIRST_BIT >> child;
+            queue[tail++] = child;
+        }
+    }
+
+    ExistsSwap best = {.change = INT_MAX, .nb_ties = 0};
+
+    for (uint64_t rest = graph->adjacency_matrix[vertex] & available & ~tree[vertex]; rest; rest &= ~(FIRST_BIT >> first_bit_position(rest)))
+    {
+        unsigned int other = first_bit_position(rest);
+
+        for (unsigned int current = other; parents[current] != vertex; current = parents[current])
+            exists_consider_swap(&best, degrees, (Edge){vertex, other}, (Edge){current, parents[current]}, seed);
+    }
+
+    for (uint64_t rest = tree[vertex]; rest; rest &= ~(FIRST_BIT >> first_bit_position(rest)))
+    {
+        unsigned int child = first_bit_position(rest);
+        uint64_t branch = branches[child];
+
+        for (uint64_t inside = branch; inside; inside &= ~(FIRST_BIT >> first_bit_position(inside)))
+        {
+            unsigned int origin = first_bit_position(inside);
+            uint64_t outside = graph->adjacency_matrix[origin] & available & ~branch & ~vertex_bit;
+
+            for (; outside; outside &= ~(FIRST_BIT >> first_bit_position(outside)))
+                exists_consider_swap(&best, degrees, (Edge){origin, first_bit_position(outside)}, (Edge){vertex, child}, seed);
+        }
+    }
+
+    if (best.nb_ties == 0)
+        return false;
+
+    tree[best.added.origin] |= FIRST_BIT >> best.added.destination;
+    tree[best.added.destination] |= FIRST_BIT >> best.added.origin;
+    tree[best.removed.origin] &= ~(FIRST_BIT >> best.removed.destination);
+    tree[best.removed.destination] &= ~(FIRST_BIT >> best.removed.origin);
+    return true;
+}
+
+// Repairs random vertices of tree degree 2 until there are none left or the moves run out
+bool exists_local_search(Graph *graph, uint64_t available, uint64_t *tree, unsigned int max_moves, uint64_t *seed, RunData *run_data)
+{
+    for (unsigned int move = 0; move < max_moves; move++)
+    {
+        uint64_t degree_two = exists_degree_two(tree, available);
+        if (degree_two == 0)
+            return true;
+
+        unsigned int skip = exists_random(seed) % count_set_bits(degree_two);
+        while (skip--)
+            degree_two &= ~(FIRST_BIT >> first_bit_position(degree_two));
+
+        if (exists_repair_vertex(graph, available, tree, first_bit_position(degree_two), seed))
+            run_data->trees_this_run += 1;
+    }
+
+    return exists_degree_two(tree, available) == 0;
+}
+
+void exists_print_tree(Graph *graph, uint64_t *tree, Output *output)
+{
+    Graph *hist = empty_graph(graph->vertices);
+
+    for (unsigned int vertex = 0; vertex < graph->vertices; vertex++)
+    {
+        for (uint64_t rest = tree[vertex]; rest; rest &= ~(FIRST_BIT >> first_bit_position(rest)))
+        {
+            unsigned int other = first_bit_position(rest);
+            if (other > vertex)
+                add_edge_to_graph(hist, &(Edge){vertex, other});
+        }
+    }
+
+    print_graph_to_output(output, hist);
+    free_graph(hist);
+}
+
+// Exhaustive search with nogoods, restarted on a random relabelling whenever it exceeds the failure limit.
+// The limit doubles with every restart, so the last run always finishes. The strategies pick edges by degrees,
+// tree state or weights and only look at labels to break ties, so a restart randomizes the tie breaking,
+// not the branching itself, and starts over without the nogoods learned before.
+bool exists_search(Graph *graph, uint64_t hidden_vertices, const HistBranching *branching, Output *output, uint64_t *seed, RunData *run_data)
+{
+    unsigned int n = graph->vertices;
+    unsigned int labels[64];
+    unsigned int positions[64];
+    Graph *relabelled = empty_graph(n);
+    Graph *tree = output ? empty_graph(n) : NULL;
+    bool found = false;
+
+    for (unsigned int i = 0; i < n; i++)
+        labels[i] = i;
+
+    for (unsigned long long int limit = EXISTS_FIRST_FAILURE_LIMIT;; limit *= 2)
+    {
+        for (unsigned int i = 0; i < n; i++)
+            positions[labels[i]] = i;
+
+        memset(relabelled->adjacency_matrix, 0, n * sizeof(uint64_t));
+        relabelled->edges = 0;
+        uint64_t hidden = 0;
+
+        for (unsigned int vertex = 0; vertex < n; vertex++)
+        {
+            if ((FIRST_BIT >> vertex) & hidden_vertices)
+                hidden |= FIRST_BIT >> positions[vertex];
+
+            for (uint64_t rest = graph->adjacency_matrix[vertex]; rest; rest &= ~(FIRST_BIT >> first_bit_position(rest)))
+            {
+                unsigned int other = first_bit_position(rest);
+                if (other > vertex)
+                    add_edge_to_graph(relabelled, &(Edge){positions[vertex], positions[other]});
+            }
+        }
+
+        AdjListGraph *alg = alg_from_graph_and_hidden(relabelled, hidden);
+        HistIterator iterator;
+        hist_iter_init(&iterator, alg, branching);
+        hist_iter_learn(&iterator);
+        iterator.failure_limit = limit;
+
+        found = hist_iter_next(&iterator, tree);
+        bool interrupted = iterator.interrupted;
+        run_data->trees_this_run += iterator.trees;
+
+        free_hist_iter(&iterator);
+        free_alg(alg);
+
+        if (!interrupted)
+            break;
+
+        for (unsigned int i = n; i > 1; i--)
+        {
+            unsigned int j = exists_random(seed) % i;
+            unsigned int label = labels[i - 1];
+            labels[i - 1] = labels[j];
+            labels[j] = label;
+        }
+    }
+
+    if (found && output)
+    {
+        uint64_t original[64] = {0};
+
+        for (unsigned int i = 0; i < n; i++)
+        {
+            for (uint64_t rest = tree->adjacency_matrix[i]; rest; rest &= ~(FIRST_BIT >> first_bit_position(rest)))
+                original[labels[i]] |= FIRST_BIT >> labels[first_bit_position(rest)];
+        }
+
+        exists_print_tree(graph, original, output);
+    }
+
+    if (tree)
+        free_graph(tree);
+
+    free_graph(relabelled);
+    return found;
+}
+
+bool hist_exists(Graph *graph, uint64_t hidden_vertices, const HistBranching *branching, Output *output, RunData *run_data)
+{
+    if (run_data == NULL)
+    {
+        fprintf(stderr, "No RunData struct provided.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    rd_start_run(run_data);
+
+    unsigned int n = graph->vertices;
+    uint64_t available = (n == 0 ? 0 : ~0ULL << (64 - n)) & ~hidden_vertices;
+    unsigned int nb_available = count_set_bits(available);
+    // Fixed seed, so the trees that are found don't change between runs
+    uint64_t seed = 0;
+    bool found = false;
+    bool settled = false;
+
+    // Graphs this small are settled by the search at once
+    if (nb_available >= 3)
+    {
+        uint64_t tree[64];
+
+        // The tree is grown from the vertex of highest degree, the lowest one on ties
+        unsigned int root = first_bit_position(available);
+        for (uint64_t rest = available; rest; rest &= ~(FIRST_BIT >> first_bit_position(rest)))
+        {
+            unsigned int vertex = first_bit_position(rest);
+            if (vertex_degree(graph->adjacency_matrix[vertex] & available) > vertex_degree(graph->adjacency_matrix[root] & available))
+                root = vertex;
+        }
+
+        // Without a spanning tree there is nothing to search for
+        if (!exists_greedy_tree(graph, available, root, tree))
+        {
+            settled = true;
+        }
+        else
+        {
+            run_data->trees_this_run += 1;
+
+            if (exists_local_search(graph, available, tree, EXISTS_MOVES_PER_VERTEX * nb_available, &seed, run_data))
+            {
+                found = true;
+                settled = true;
+
+                if (output)
+                    exists_print_tree(graph, tree, output);
+            }
+        }
+    }
+
+    if (!settled)
+        found = exists_search(graph, hidden_vertices, branching, output, &seed, run_data);
+
+    if (found)
+        run_data->hists_this_run += 1;
+
+    rd_finish_run(run_data);
+    return found;
+}
+
+bool is_hypohist_exists(Graph *graph, const HistBranching *branching, Output *output, bool only_partials, RunData *run_data)
+{
+    if (!only_partials && hist_exists(graph, 0, branching, NULL, run_data))
+        return false;
+
+    for (unsigned int vertex = 0; vertex < graph->vertices; vertex++)
+    {
+        if (!hist_exists(graph, FIRST_BIT >> vertex, branching, output, run_data))
+            return false;
+    }
+
+    return true;
+}
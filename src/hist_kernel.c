@@ -0,0 +1,211 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <hist_kernel.h>
+#include <adjlist.h>
+
+HistKernel *kernel_new(Graph *graph, uint64_t hidden_vertices)
+{
+    HistKernel *kernel = malloc(sizeof(HistKernel));
+
+    if (kernel == NULL)
+    {
+        fprintf(stderr, "Failed to allocate kernel.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    unsigned int n = graph->vertices;
+    kernel->graph = NULL;
+    kernel->nb_forced_edges = 0;
+
+    uint64_t available = n == 0 ? 0 : ~0ULL << (64 - n);
+    available &= ~hidden_vertices;
+
+    uint64_t adjacencies[64];
+    for (unsigned int v = 0; v < n; v++)
+        adjacencies[v] = (FIRST_BIT >> v) & available ? graph->adjacency_matrix[v] & available : 0;
+
+    bool feasible = true;
+    bool changed = true;
+
+    // With two vertices left the only HIST is the edge between them
+    while (changed && feasible && count_set_bits(available) > 2)
+    {
+        changed = false;
+
+        for (uint64_t rest = available; rest && feasible; rest &= ~(FIRST_BIT >> first_bit_position(rest)))
+        {
+            unsigned int vertex = first_bit_position(rest);
+            unsigned int degree = vertex_degree(adjacencies[vertex]);
+
+            feasible = degree > 0;
+            if (degree > 2)
+                continue;
+
+            // Both endpoints would be leaves, which only works if they are the whole tree
+            for (uint64_t neighbours = adjacencies[vertex]; neighbours; neighbours &= ~(FIRST_BIT >> first_bit_position(neighbours)))
+            {
+                unsigned int neighbour = first_bit_position(neighbours);
+                if (vertex_degree(adjacencies[neighbour]) > 2)
+                    continue;
+
+                adjacencies[vertex] &= ~(FIRST_BIT >> neighbour);
+                adjacencies[neighbour] &= ~(FIRST_BIT >> vertex);
+                changed = true;
+            }
+        }
+
+        for (uint64_t rest = available; rest && feasible; rest &= ~(FIRST_BIT >> first_bit_position(rest)))
+        {
+            unsigned int vertex = first_bit_position(rest);
+            unsigned int nb_leaves = 0;
+
+            for (uint64_t neighbours = adjacencies[vertex]; neighbours; neighbours &= ~(FIRST_BIT >> first_bit_position(neighbours)))
+            {
+                unsigned int neighbour = first_bit_position(neighbours);
+                if (vertex_degree(adjacencies[neighbour]) != 1 || ++nb_leaves <= KERNEL_KEPT_LEAVES)
+                    continue;
+
+                Edge *forced = &kernel->forced_edges[kernel->nb_forced_edges++];
+                forced->origin = vertex;
+                forced->destination = neighbour;
+
+                available &= ~(FIRST_BIT >> neighbour);
+                adjacencies[vertex] &= ~(FIRST_BIT >> neighbour);
+                adjacencies[neighbour] = 0;
+                changed = true;
+            }
+        }
+    }
+
+    if (!feasible)
+        return kernel;
+
+    int positions[64];
+    unsigned int nb_vertices = 0;
+
+    for (uint64_t rest = available; rest; rest &= ~(FIRST_BIT >> first_bit_position(rest)))
+    {
+        unsigned int vertex = first_bit_position(rest);
+        positions[vertex] = nb_vertices;
+        kernel->labels[nb_vertices++] = vertex;
+    }
+
+    kernel->graph = empty_graph(nb_vertices);
+
+    for (unsigned int i = 0; i < nb_vertices; i++)
+    {
+        unsigned int vertex = kernel->labels[i];
+
+        for (uint64_t neighbours = adjacencies[vertex]; neighbours; neighbours &= ~(FIRST_BIT >> first_bit_position(neighbours)))
+        {
+            unsigned int neighbour = first_bit_position(neighbours);
+            if (neighbour < vertex)
+                continue;
+
+            Edge edge = {i, positions[neighbour]};
+            add_edge_to_graph(kernel->graph, &edge);
+        }
+    }
+
+    return kernel;
+}
+
+void free_kernel(HistKernel *kernel)
+{
+    if (kernel->graph)
+        free_graph(kernel->graph);
+
+    free(kernel);
+}
+
+void kernel_expand_tree(HistKernel *kernel, Graph *kernel_tree, Graph *tree)
+{
+    memset(tree->adjacency_matrix, 0, tree->vertices * sizeof(uint64_t));
+    tree->edges = 0;
+
+    for (unsigned int i = 0; i < kernel_tree->vertices; i++)
+    {
+        for (uint64_t neighbours = kernel_tree->adjacency_matrix[i]; neighbours; neighbours &= ~(FIRST_BIT >> first_bit_position(neighbours)))
+        {
+            unsigned int j = first_bit_position(neighbours);
+            if (j < i)
+                continue;
+
+            Edge edge = {kernel->labels[i], kernel->labels[j]};
+            add_edge_to_graph(tree, &edge);
+        }
+    }
+
+    for (unsigned int e = 0; e < kernel->nb_forced_edges; e++)
+        add_edge_to_graph(tree, &kernel->forced_edges[e]);
+}
+
+bool find_hists_kernel(Graph *input_graph, uint64_t hidden_vertices, const HistBranching *branching, Output *output, bool find_one, RunData *run_data)
+{
+    if (run_data == NULL)
+    {
+        fprintf(stderr, "No RunData struct provided.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    HistKernel *kernel = kernel_new(input_graph, hidden_vertices);
+
+    rd_start_run(run_data);
+
+    if (kernel->graph)
+    {
+        AdjListGraph *graph = alg_from_graph_and_hidden(kernel->graph, 0);
+        Graph *kernel_tree = output ? empty_graph(kernel->graph->vertices) : NULL;
+        Graph *tree = output ? empty_graph(input_graph->vertices) : NULL;
+
+        HistIterator iterator;
+        hist_iter_init(&iterator, graph, branching);
+
+        if (find_one)
+            hist_iter_learn(&iterator);
+
+        while (hist_iter_next(&iterator, kernel_tree))
+        {
+            if (output)
+            {
+                kernel_expand_tree(kernel, kernel_tree, tree);
+                print_graph_to_output(output, tree);
+            }
+
+            run_data->hists_this_run += 1;
+
+            if (find_one)
+                break;
+        }
+
+        run_data->trees_this_run += iterator.trees;
+
+        free_hist_iter(&iterator);
+        if (output)
+        {
+            free_graph(kernel_tree);
+            free_graph(tree);
+        }
+        free_alg(graph);
+    }
+
+    rd_finish_run(run_data);
+    free_kernel(kernel);
+
+    return run_data->hists_this_run != 0;
+}
+
+bool is_hypohist_kernel(Graph *input_graph, const HistBranching *branching, Output *output, bool only_partials, RunData *run_data)
+{
+    if (!only_partials && find_hists_kernel(input_graph, 0, branching, output, true, run_data))
+        return false;
+
+    for (unsigned int vertex = 0; vertex < input_graph->vertices; vertex++)
+    {
+        if (!find_hists_kernel(input_graph, FIRST_BIT >> vertex, branching, output, true, run_data))
+            return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,242 @@
+#include <stdlib.h>
+#include <immintrin.h>
+
+#include <hist_table.h>
+
+// Tables built so far, indexed by order
+HistTable *hist_tables[TABLE_MAX_VERTICES + 1];
+
+unsigned int table_edge_bit(unsigned int a, unsigned int b)
+{
+    unsigned int i = a < b ? a : b;
+    unsigned int j = a < b ? b : a;
+
+    return j * (j - 1) / 2 + i;
+}
+
+uint64_t table_edge_mask(Graph *graph)
+{
+    uint64_t mask = 0;
+
+    for (unsigned int j = 1; j < graph->vertices; j++)
+    {
+        for (unsigned int i = 0; i < j; i++)
+        {
+            if (graph->adjacency_matrix[j] & (FIRST_BIT >> i))
+                mask |= 1ULL << table_edge_bit(i, j);
+        }
+    }
+
+    return mask;
+}
+
+void table_add_mask(HistTable *table, uint64_t mask, unsigned int *capacity)
+{
+    if (table->nb_masks == *capacity)
+    {
+        *capacity *= 2;
+        table->masks = realloc(table->masks, *capacity * sizeof(uint64_t));
+
+        if (table->masks == NULL)
+        {
+            fprintf(stderr, "Failed to grow HIST table\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    table->masks[table->nb_masks++] = mask;
+}
+
+// Edges of the labeled tree with the given Pruefer sequence, which has length vertices - 2
+uint64_t table_decode_pruefer(unsigned int vertices, const unsigned int *sequence)
+{
+    unsigned int degrees[TABLE_MAX_VERTICES];
+    uint64_t mask = 0;
+
+    for (unsigned int v = 0; v < vertices; v++)
+        degrees[v] = 1;
+    for (unsigned int i = 0; i + 2 < vertices; i++)
+        degrees[sequence[i]]++;
+
+    for (unsigned int i = 0; i + 2 < vertices; i++)
+    {
+        unsigned int leaf = 0;
+        while (degrees[leaf] != 1)
+            leaf++;
+
+        mask |= 1ULL << table_edge_bit(leaf, sequence[i]);
+        degrees[leaf]--;
+        degrees[sequence[i]]--;
+    }
+
+    // The two vertices left are joined by the last edge
+    unsigned int ends[2];
+    unsigned int nb_ends = 0;
+    for (unsigned int v = 0; v < vertices; v++)
+    {
+        if (degrees[v] == 1)
+            ends[nb_ends++] = v;
+    }
+
+    return mask | 1ULL << table_edge_bit(ends[0], ends[1]);
+}
+
+HistTable *hist_table_build(unsigned int vertices)
+{
+    HistTable *table = malloc(sizeof(HistTable));
+    unsigned int capacity = 64;
+
+    if (table == NULL)
+    {
+        fprintf(stderr, "Failed to allocate HIST table\n");
+        exit(EXIT_FAILURE);
+    }
+
+    table->vertices = vertices;
+    table->masks = malloc(capacity * sizeof(uint64_t));
+    table->nb_masks = 0;
+
+    if (table->masks == NULL)
+    {
+        fprintf(stderr, "Failed to allocate HIST table\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (vertices == 1)
+    {
+        table_add_mask(table, 0, &capacity);
+    }
+    else if (vertices == 2)
+    {
+        table_add_mask(table, 1ULL << table_edge_bit(0, 1), &capacity);
+    }
+    else
+    {
+        // Odometer over all sequences, keeping track of how many vertices occur exactly once
+        unsigned int length = vertices - 2;
+        unsigned int sequence[TABLE_MAX_VERTICES] = {0};
+        unsigned int occurrences[TABLE_MAX_VERTICES] = {0};
+        unsigned int nb_single = 0;
+
+        occurrences[0] = length;
+        nb_single = length == 1;
+
+        while (true)
+        {
+            if (nb_single == 0)
+                table_add_mask(table, table_decode_pruefer(vertices, sequence), &capacity);
+
+            unsigned int position = 0;
+            while (position < length && sequence[position] == vertices - 1)
+            {
+                nb_single -= occurrences[vertices - 1] == 1;
+                occurrences[vertices - 1]--;
+                nb_single += occurrences[vertices - 1] == 1;
+
+                sequence[position] = 0;
+
+                nb_single -= occurrences[0] == 1;
+                occurrences[0]++;
+                nb_single += occurrences[0] == 1;
+
+                position++;
+            }
+
+            if (position == length)
+                break;
+
+            unsigned int old = sequence[position]++;
+            nb_single -= (occurrences[old] == 1) + (occurrences[old + 1] == 1);
+            occurrences[old]--;
+            occurrences[old + 1]++;
+            nb_single += (occurrences[old] == 1) + (occurrences[old + 1] == 1);
+        }
+    }
+
+    unsigned int nb_masks = table->nb_masks;
+
+    while (table->nb_masks % TABLE_LANES != 0)
+        table_add_mask(table, ~0ULL, &capacity);
+
+    table->nb_padded_masks = table->nb_masks;
+    table->nb_masks = nb_masks;
+
+    return table;
+}
+
+HistTable *hist_table(unsigned int vertices)
+{
+    if (hist_tables[vertices] == NULL)
+        hist_tables[vertices] = hist_table_build(vertices);
+
+    return hist_tables[vertices];
+}
+
+/*
+ * Counting
+ * A mask is a HIST of the graph if it has no edge in missing, the complement of the graph's edges.
+ * Every path adds the outcome of the test to a counter instead of branching on it.
+ */
+unsigned long long int table_count_scalar(const uint64_t *masks, unsigned int nb_masks, uint64_t missing)
+{
+    unsigned long long int count = 0;
+
+    for (unsigned int i = 0; i < nb_masks; i++)
+        count += (masks[i] & missing) == 0;
+
+    return count;
+}
+
+__attribute__((target("avx2"))) unsigned long long int table_count_avx2(const uint64_t *masks, unsigned int nb_masks, uint64_t missing)
+{
+    __m256i missing_lanes = _mm256_set1_epi64x(missing);
+    __m256i zero = _mm256_setzero_si256();
+    __m256i counts = _mm256_setzero_si256();
+
+    for (unsigned int i = 0; i < nb_masks; i += 4)
+    {
+        __m256i lanes = _mm256_loadu_si256((const __m256i *)(masks + i));
+        // Lanes without a missing edge compare equal to zero and subtract -1
+        __m256i contained = _mm256_cmpeq_epi64(_mm256_and_si256(lanes, missing_lanes), zero);
+        counts = _mm256_sub_epi64(counts, contained);
+    }
+
+    uint64_t lane_counts[4];
+    _mm256_storeu_si256((__m256i *)lane_counts, counts);
+
+    return lane_counts[0] + lane_counts[1] + lane_counts[2] + lane_counts[3];
+}
+
+__attribute__((target("avx512f"))) unsigned long long int table_count_avx512(const uint64_t *masks, unsigned int nb_masks, uint64_t missing)
+{
+    __m512i missing_lanes = _mm512_set1_epi64(missing);
+    unsigned long long int count = 0;
+
+    for (unsigned int i = 0; i < nb_masks; i += 8)
+    {
+        __m512i lanes = _mm512_loadu_si512((const void *)(masks + i));
+        count += __builtin_popcount(_mm512_testn_epi64_mask(lanes, missing_lanes));
+    }
+
+    return count;
+}
+
+bool count_hists_table(Graph *graph, BigNat *count)
+{
+    if (graph->vertices == 0 || graph->vertices > TABLE_MAX_VERTICES)
+        return false;
+
+    HistTable *table = hist_table(graph->vertices);
+    uint64_t missing = ~table_edge_mask(graph);
+    unsigned long long int nb_hists;
+
+    if (__builtin_cpu_supports("avx512f"))
+        nb_hists = table_count_avx512(table->masks, table->nb_padded_masks, missing);
+    else if (__builtin_cpu_supports("avx2"))
+        nb_hists = table_count_avx2(table->masks, table->nb_padded_masks, missing);
+    else
+        nb_hists = table_count_scalar(table->masks, table->nb_padded_masks, missing);
+
+    *count = bignat_from_u64(nb_hists);
+    return true;
+}
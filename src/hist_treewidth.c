@@ -0,0 +1,758 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <hist_treewidth.h>
+#include <kirchhoff.h>
+#include <modular.h>
+
+#define TD_LABEL(labels, position) ((int)(((labels) >> (4 * (position))) & 15))
+#define TD_DEGREE(degrees, position) ((int)(((degrees) >> (2 * (position))) & 3))
+
+/*
+ * Partial solutions for one bag. A state stores for every bag position the component label
+ * of the partial forest (4 bits, numbered in order of first appearance) and the tree degree
+ * so far capped at 3 (2 bits). Counts are kept modulo every prime.
+ */
+typedef struct TdTable
+{
+    int bag_size;
+    int bag[TD_MAX_BAG];
+    int nb_primes;
+    // State i has labels[i], degrees[i] and the residues counts[i * nb_primes + k]
+    uint64_t *labels;
+    uint64_t *degrees;
+    uint64_t *counts;
+    int size;
+    int capacity;
+    // Open addressing on the states, -1 marks an empty slot
+    int *slots;
+    int nb_slots;
+    // Set when the table would exceed TD_MAX_STATES, the counts are incomplete
+    bool overflow;
+} TdTable;
+
+TdTable *td_table_new(int *bag, int bag_size, int nb_primes)
+{
+    TdTable *table = malloc(sizeof(TdTable));
+
+    if (table == NULL)
+    {
+        fprintf(stderr, "Failed to allocate decomposition table.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    table->bag_size = bag_size;
+    memcpy(table->bag, bag, bag_size * sizeof(int));
+    table->nb_primes = nb_primes;
+    table->size = 0;
+    table->capacity = 16;
+    table->labels = malloc(table->capacity * sizeof(uint64_t));
+    table->degrees = malloc(table->capacity * sizeof(uint64_t));
+    table->counts = malloc(table->capacity * nb_primes * sizeof(uint64_t));
+    table->nb_slots = 32;
+    table->slots = malloc(table->nb_slots * sizeof(int));
+    table->overflow = false;
+
+    if (table->labels == NULL || table->degrees == NULL || table->counts == NULL || table->slots == NULL)
+    {
+        fprintf(stderr, "Failed to allocate decomposition table.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    memset(table->slots, -1, table->nb_slots * sizeof(int));
+    return table;
+}
+
+void free_td_table(TdTable *table)
+{
+    free(table->labels);
+    free(table->degrees);
+    free(table->counts);
+    free(table->slots);
+    free(table);
+}
+
+uint64_t td_hash(uint64_t labels, uint64_t degrees)
+{
+    uint64_t hash = labels * 0x9e3779b97f4a7c15ULL ^ degrees * 0xc2b2ae3d27d4eb4fULL;
+    return hash ^ (hash >> 31);
+}
+
+int td_find_slot(TdTable *table, uint64_t labels, uint64_t degrees)
+{
+    int mask = table->nb_slots - 1;
+    int slot = td_hash(labels, degrees) & mask;
+
+    while (table->slots[slot] >= 0)
+    {
+        int state = table->slots[slot];
+        if (table->labels[state] == labels && table->degrees[state] == degrees)
+            break;
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
+
+void td_grow(TdTable *table)
+{
+    table->capacity *= 2;
+    table->labels = realloc(table->labels, table->capacity * sizeof(uint64_t));
+    table->degrees = realloc(table->degrees, table->capacity * sizeof(uint64_t));
+    table->counts = realloc(table->counts, table->capacity * table->nb_primes * sizeof(uint64_t));
+
+    free(table->slots);
+    table->nb_slots = 2 * table->capacity;
+    table->slots = malloc(table->nb_slots * sizeof(int));
+
+    if (table->labels == NULL || table->degrees == NULL || table->counts == NULL || table->slots == NULL)
+    {
+        fprintf(stderr, "Failed to grow decomposition table.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    memset(table->slots, -1, table->nb_slots * sizeof(int));
+    for (int state = 0; state < table->size; state++)
+        table->slots[td_find_slot(table, table->labels[state], table->degrees[state])] = state;
+}
+
+// Adds the residues to the counts of the state, creating it if needed
+void td_add_state(TdTable *table, uint64_t labels, uint64_t degrees, const uint64_t *counts, const uint64_t *primes)
+{
+    if (table->overflow)
+        return;
+
+    int slot = td_find_slot(table, labels, degrees);
+    int state = table->slots[slot];
+
+    if (state >= 0)
+    {
+        uint64_t *state_counts = &table->counts[state * table->nb_primes];
+        for (int k = 0; k < table->nb_primes; k++)
+            state_counts[k] = mod_add(state_counts[k], counts[k], primes[k]);
+        return;
+    }
+
+    if (table->size == TD_MAX_STATES)
+    {
+        table->overflow = true;
+        return;
+    }
+
+    state = table->size++;
+    table->labels[state] = labels;
+    table->degrees[state] = degrees;
+    memcpy(&table->counts[state * table->nb_primes], counts, table->nb_primes * sizeof(uint64_t));
+    table->slots[slot] = state;
+
+    if (table->size == table->capacity)
+        td_grow(table);
+}
+
+// Renumbers the component labels in order of first appearance, so equal partitions get equal labels
+uint64_t td_normalize(uint64_t labels, int bag_size)
+{
+    int mapping[16];
+    memset(mapping, -1, sizeof(mapping));
+
+    uint64_t result = 0;
+    int next = 0;
+
+    for (int position = 0; position < bag_size; position++)
+    {
+        int label = TD_LABEL(labels, position);
+        if (mapping[label] < 0)
+            mapping[label] = next++;
+        result |= (uint64_t)mapping[label] << (4 * position);
+    }
+
+    return result;
+}
+
+uint64_t td_increment_degree(uint64_t degrees, int position)
+{
+    return TD_DEGREE(degrees, position) < 3 ? degrees + (1ULL << (2 * position)) : degrees;
+}
+
+// Every bag vertex isolated with tree degree 0
+TdTable *td_isolated(int *bag, int bag_size, int nb_primes, const uint64_t *primes)
+{
+    TdTable *table = td_table_new(bag, bag_size, nb_primes);
+
+    uint64_t labels = 0;
+    for (int position = 0; position < bag_size; position++)
+        labels |= (uint64_t)position << (4 * position);
+
+    uint64_t ones[NB_MODULAR_PRIMES];
+    for (int k = 0; k < nb_primes; k++)
+        ones[k] = 1;
+
+    td_add_state(table, labels, 0, ones, primes);
+    return table;
+}
+
+// Leaves out or adds one edge between the vertices at positions i and j. Consumes the table.
+TdTable *td_introduce_edge(TdTable *table, int i, int j, const uint64_t *primes)
+{
+    TdTable *result = td_table_new(table->bag, table->bag_size, table->nb_primes);
+    result->overflow = table->overflow;
+
+    for (int state = 0; state < table->size; state++)
+    {
+        uint64_t labels = table->labels[state];
+        uint64_t degrees = table->degrees[state];
+        uint64_t *counts = &table->counts[state * table->nb_primes];
+
+        td_add_state(result, labels, degrees, counts, primes);
+
+        // Both endpoints in the same component would close a cycle
+        int label_i = TD_LABEL(labels, i);
+        int label_j = TD_LABEL(labels, j);
+        if (label_i == label_j)
+            continue;
+
+        uint64_t merged = 0;
+        for (int position = 0; position < table->bag_size; position++)
+        {
+            int label = TD_LABEL(labels, position);
+            merged |= (uint64_t)(label == label_j ? label_i : label) << (4 * position);
+        }
+
+        degrees = td_increment_degree(td_increment_degree(degrees, i), j);
+        td_add_state(result, td_normalize(merged, table->bag_size), degrees, counts, primes);
+    }
+
+    free_td_table(table);
+    return result;
+}
+
+// Removes the vertex at the given position once all its edges have been introduced, so its tree degree is final.
+// States where it has degree 2 are dropped, as are states where its component has no other bag vertex left
+// while other vertices remain, it could never be joined to them. Consumes the table.
+TdTable *td_forget(TdTable *table, int forgotten, const uint64_t *primes)
+{
+    int bag[TD_MAX_BAG];
+    int bag_size = 0;
+    for (int position = 0; position < table->bag_size; position++)
+    {
+        if (position != forgotten)
+            bag[bag_size++] = table->bag[position];
+    }
+
+    TdTable *result = td_table_new(bag, bag_size, table->nb_primes);
+    result->overflow = table->overflow;
+
+    for (int state = 0; state < table->size; state++)
+    {
+        uint64_t labels = table->labels[state];
+        uint64_t degrees = table->degrees[state];
+
+        if (TD_DEGREE(degrees, forgotten) == 2)
+            continue;
+
+        int label = TD_LABEL(labels, forgotten);
+        bool shared = false;
+
+        uint64_t new_labels = 0;
+        uint64_t new_degrees = 0;
+        int new_position = 0;
+
+        for (int position = 0; position < table->bag_size; position++)
+        {
+            if (position == forgotten)
+                continue;
+
+            if (TD_LABEL(labels, position) == label)
+                shared = true;
+
+            new_labels |= (uint64_t)TD_LABEL(labels, position) << (4 * new_position);
+            new_degrees |= (uint64_t)TD_DEGREE(degrees, position) << (2 * new_position);
+            new_position++;
+        }
+
+        if (!shared && bag_size > 0)
+            continue;
+
+        td_add_state(result, td_normalize(new_labels, bag_size), new_degrees, &table->counts[state * table->nb_primes], primes);
+    }
+
+    free_td_table(table);
+    return result;
+}
+
+// The same states over a bag that contains the current one, new vertices are isolated. Consumes the table.
+TdTable *td_extend(TdTable *table, int *bag, int bag_size, const uint64_t *primes)
+{
+    int sources[TD_MAX_BAG];
+    for (int position = 0; position < bag_size; position++)
+    {
+        sources[position] = -1;
+        for (int source = 0; source < table->bag_size; source++)
+        {
+            if (table->bag[source] == bag[position])
+                sources[position] = source;
+        }
+    }
+
+    TdTable *result = td_table_new(bag, bag_size, table->nb_primes);
+    result->overflow = table->overflow;
+
+    for (int state = 0; state < table->size; state++)
+    {
+        uint64_t labels = table->labels[state];
+        uint64_t degrees = table->degrees[state];
+
+        uint64_t new_labels = 0;
+        uint64_t new_degrees = 0;
+        // Normalized labels are below the old bag size, so fresh labels start there
+        int fresh_label = table->bag_size;
+
+        for (int position = 0; position < bag_size; position++)
+        {
+            int source = sources[position];
+
+            if (source < 0)
+            {
+                new_labels |= (uint64_t)fresh_label++ << (4 * position);
+                continue;
+            }
+
+            new_labels |= (uint64_t)TD_LABEL(labels, source) << (4 * position);
+            new_degrees |= (uint64_t)TD_DEGREE(degrees, source) << (2 * position);
+        }
+
+        td_add_state(result, td_normalize(new_labels, bag_size), new_degrees, &table->counts[state * table->nb_primes], primes);
+    }
+
+    free_td_table(table);
+    return result;
+}
+
+int td_find(int *parents, int label)
+{
+    while (parents[label] != label)
+        label = parents[label] = parents[parents[label]];
+
+    return label;
+}
+
+// Combines partial forests of two subtrees on the same bag, whose edge sets are disjoint. Consumes both tables.
+TdTable *td_join(TdTable *a, TdTable *b, const uint64_t *primes)
+{
+    int bag_size = a->bag_size;
+    int nb_primes = a->nb_primes;
+
+    TdTable *result = td_table_new(a->bag, bag_size, nb_primes);
+    result->overflow = a->overflow || b->overflow;
+
+    uint64_t counts[NB_MODULAR_PRIMES];
+
+    for (int state_a = 0; state_a < a->size && !result->overflow; state_a++)
+    {
+        uint64_t labels_a = a->labels[state_a];
+        uint64_t degrees_a = a->degrees[state_a];
+
+        for (int state_b = 0; state_b < b->size; state_b++)
+        {
+            uint64_t labels_b = b->labels[state_b];
+            uint64_t degrees_b = b->degrees[state_b];
+
+            // Components of a joined along the components of b, connecting
+            // two positions that are already connected would close a cycle
+            int parents[16];
+            int first_in_b[16];
+            for (int label = 0; label < 16; label++)
+            {
+                parents[label] = label;
+                first_in_b[label] = -1;
+            }
+
+            bool cycle = false;
+            for (int position = 0; position < bag_size && !cycle; position++)
+            {
+                int label_a = TD_LABEL(labels_a, position);
+                int label_b = TD_LABEL(labels_b, position);
+
+                if (first_in_b[label_b] < 0)
+                {
+                    first_in_b[label_b] = label_a;
+                    continue;
+                }
+
+                int root = td_find(parents, label_a);
+                int other_root = td_find(parents, first_in_b[label_b]);
+
+                if (root == other_root)
+                    cycle = true;
+                else
+                    parents[root] = other_root;
+            }
+
+            if (cycle)
+                continue;
+
+            uint64_t labels = 0;
+            uint64_t degrees = 0;
+            for (int position = 0; position < bag_size; position++)
+            {
+                int degree = TD_DEGREE(degrees_a, position) + TD_DEGREE(degrees_b, position);
+                labels |= (uint64_t)td_find(parents, TD_LABEL(labels_a, position)) << (4 * position);
+                degrees |= (uint64_t)(degree < 3 ? degree : 3) << (2 * position);
+            }
+
+            for (int k = 0; k < nb_primes; k++)
+                counts[k] = mod_mul(a->counts[state_a * nb_primes + k], b->counts[state_b * nb_primes + k], primes[k]);
+
+            td_add_state(result, td_normalize(labels, bag_size), degrees, counts, primes);
+        }
+    }
+
+    free_td_table(a);
+    free_td_table(b);
+    return result;
+}
+
+typedef struct TdNeighbours
+{
+    int *vertices;
+    int size;
+    int capacity;
+} TdNeighbours;
+
+void tn_append(TdNeighbours *neighbours, int vertex)
+{
+    if (neighbours->size == neighbours->capacity)
+    {
+        neighbours->capacity = neighbours->capacity ? 2 * neighbours->capacity : 4;
+        neighbours->vertices = realloc(neighbours->vertices, neighbours->capacity * sizeof(int));
+
+        if (neighbours->vertices == NULL)
+        {
+            fprintf(stderr, "Failed to grow neighbour set.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    neighbours->vertices[neighbours->size++] = vertex;
+}
+
+void tn_remove(TdNeighbours *neighbours, int vertex)
+{
+    for (int i = 0; i < neighbours->size; i++)
+    {
+        if (neighbours->vertices[i] == vertex)
+        {
+            neighbours->vertices[i] = neighbours->vertices[--neighbours->size];
+            return;
+        }
+    }
+}
+
+// Priority of a vertex in the elimination order: the number of fill edges its elimination adds, ties broken
+// by degree. Vertices whose bag would be too large come last, so their fill is not worth computing.
+int td_fill_key(TdNeighbours *neighbours, int v, int *marks, int *stamp)
+{
+    TdNeighbours *set = &neighbours[v];
+    if (set->size + 1 > TD_MAX_BAG)
+        return (1 << 20) + set->size;
+
+    int fill = 0;
+    for (int i = 0; i < set->size; i++)
+    {
+        int a = set->vertices[i];
+
+        (*stamp)++;
+        for (int j = 0; j < neighbours[a].size; j++)
+            marks[neighbours[a].vertices[j]] = *stamp;
+
+        for (int j = i + 1; j < set->size; j++)
+            fill += marks[set->vertices[j]] != *stamp;
+    }
+
+    return fill * TD_MAX_BAG + set->size;
+}
+
+// Minimum fill elimination order. The bag of a vertex is the vertex itself followed by its neighbours
+// when it is eliminated, those neighbours are turned into a clique. Returns false if a bag gets larger than max_bag.
+bool td_eliminate(int n, int *offsets, int *adjacent, int *order, int *bags, int *bag_sizes, int max_bag)
+{
+    TdNeighbours *neighbours = calloc(n, sizeof(TdNeighbours));
+    int *marks = malloc(n * sizeof(int));
+    int *updated = malloc(n * sizeof(int));
+    int *keys = malloc(n * sizeof(int));
+    bool *eliminated = calloc(n, sizeof(bool));
+    DegreeHeap heap = {NULL, NULL, 0, 0};
+
+    if (neighbours == NULL || marks == NULL || updated == NULL || keys == NULL || eliminated == NULL)
+    {
+        fprintf(stderr, "Failed to allocate elimination.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int v = 0; v < n; v++)
+    {
+        marks[v] = -1;
+        updated[v] = -1;
+    }
+
+    // Parallel edges only count once for the decomposition
+    for (int v = 0; v < n; v++)
+    {
+        for (int i = offsets[v]; i < offsets[v + 1]; i++)
+        {
+            if (marks[adjacent[i]] != v)
+            {
+                marks[adjacent[i]] = v;
+                tn_append(&neighbours[v], adjacent[i]);
+            }
+        }
+    }
+
+    int stamp = n;
+    for (int v = 0; v < n; v++)
+    {
+        keys[v] = td_fill_key(neighbours, v, marks, &stamp);
+        dh_push(&heap, keys[v], v);
+    }
+
+    bool success = true;
+
+    for (int step = 0; step < n && success; step++)
+    {
+        int key, v;
+        do
+            dh_pop(&heap, &key, &v);
+        while (eliminated[v] || key != keys[v]);
+
+        eliminated[v] = true;
+        order[step] = v;
+
+        TdNeighbours *bag = &neighbours[v];
+        if (bag->size + 1 > max_bag)
+        {
+            success = false;
+            break;
+        }
+
+        bags[v * TD_MAX_BAG] = v;
+        memcpy(&bags[v * TD_MAX_BAG + 1], bag->vertices, bag->size * sizeof(int));
+        bag_sizes[v] = bag->size + 1;
+
+        for (int i = 0; i < bag->size; i++)
+            tn_remove(&neighbours[bag->vertices[i]], v);
+
+        for (int i = 0; i < bag->size; i++)
+        {
+            int a = bag->vertices[i];
+
+            stamp++;
+            for (int j = 0; j < neighbours[a].size; j++)
+                marks[neighbours[a].vertices[j]] = stamp;
+
+            for (int j = 0; j < bag->size; j++)
+            {
+                int b = bag->vertices[j];
+                if (b != a && marks[b] != stamp)
+                    tn_append(&neighbours[a], b);
+            }
+        }
+
+        // The fill of a vertex changes when it or one of its neighbours got new edges
+        for (int i = 0; i < bag->size; i++)
+        {
+            int a = bag->vertices[i];
+
+            for (int j = -1; j < neighbours[a].size; j++)
+            {
+                int w = j < 0 ? a : neighbours[a].vertices[j];
+                if (updated[w] == step)
+                    continue;
+
+                updated[w] = step;
+                keys[w] = td_fill_key(neighbours, w, marks, &stamp);
+                dh_push(&heap, keys[w], w);
+            }
+        }
+    }
+
+    for (int v = 0; v < n; v++)
+        free(neighbours[v].vertices);
+
+    free(neighbours);
+    free(marks);
+    free(updated);
+    free(keys);
+    free(eliminated);
+    free(heap.degrees);
+    free(heap.vertices);
+    return success;
+}
+
+bool count_hists_td_mod(EdgeList *edge_list, const uint64_t *primes, int nb_primes, uint64_t *residues, int max_bag)
+{
+    int n = edge_list->vertices;
+
+    // A single vertex is a HIST, other graphs need every vertex in the tree
+    if (n == 1 || !edge_list_is_connected(edge_list))
+    {
+        for (int k = 0; k < nb_primes; k++)
+            residues[k] = n == 1;
+        return true;
+    }
+
+    // Adjacency arrays with every parallel edge, self loops are left out
+    int *offsets = calloc(n + 1, sizeof(int));
+    int *adjacent = malloc((2 * edge_list->edges + 1) * sizeof(int));
+    int *order = malloc(n * sizeof(int));
+    int *positions = malloc(n * sizeof(int));
+    int *bags = malloc(n * TD_MAX_BAG * sizeof(int));
+    int *bag_sizes = malloc(n * sizeof(int));
+    TdTable **pending = calloc(n, sizeof(TdTable *));
+
+    if (offsets == NULL || adjacent == NULL || order == NULL || positions == NULL || bags == NULL || bag_sizes == NULL || pending == NULL)
+    {
+        fprintf(stderr, "Failed to allocate tree decomposition.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int e = 0; e < edge_list->edges; e++)
+    {
+        if (edge_list->origins[e] == edge_list->destinations[e])
+            continue;
+
+        offsets[edge_list->origins[e] + 1]++;
+        offsets[edge_list->destinations[e] + 1]++;
+    }
+
+    for (int v = 0; v < n; v++)
+        offsets[v + 1] += offsets[v];
+
+    for (int e = 0; e < edge_list->edges; e++)
+    {
+        int origin = edge_list->origins[e];
+        int destination = edge_list->destinations[e];
+
+        if (origin == destination)
+            continue;
+
+        adjacent[offsets[origin]++] = destination;
+        adjacent[offsets[destination]++] = origin;
+    }
+
+    for (int v = n; v > 0; v--)
+        offsets[v] = offsets[v - 1];
+    offsets[0] = 0;
+
+    bool success = td_eliminate(n, offsets, adjacent, order, bags, bag_sizes, max_bag);
+
+    for (int step = 0; step < n && success; step++)
+        positions[order[step]] = step;
+
+    // Vertices in elimination order, every table is passed on to the first eliminated vertex of its bag.
+    // The graph is connected, so the last vertex is the only one without such a parent.
+    for (int step = 0; step < n && success; step++)
+    {
+        int v = order[step];
+        int *bag = &bags[v * TD_MAX_BAG];
+
+        TdTable *table = pending[v] ? pending[v] : td_isolated(bag, bag_sizes[v], nb_primes, primes);
+        pending[v] = NULL;
+
+        // Edges to vertices eliminated earlier were introduced in the subtrees
+        for (int i = offsets[v]; i < offsets[v + 1] && !table->overflow; i++)
+        {
+            int w = adjacent[i];
+            if (positions[w] < step)
+                continue;
+
+            int position = 1;
+            while (bag[position] != w)
+                position++;
+
+            table = td_introduce_edge(table, 0, position, primes);
+        }
+
+        table = td_forget(table, 0, primes);
+
+        if (table->overflow)
+        {
+            free_td_table(table);
+            success = false;
+            break;
+        }
+
+        if (table->bag_size == 0)
+        {
+            for (int k = 0; k < nb_primes; k++)
+                residues[k] = table->size ? table->counts[k] : 0;
+
+            free_td_table(table);
+            continue;
+        }
+
+        int parent = table->bag[0];
+        for (int position = 1; position < table->bag_size; position++)
+        {
+            if (positions[table->bag[position]] < positions[parent])
+                parent = table->bag[position];
+        }
+
+        table = td_extend(table, &bags[parent * TD_MAX_BAG], bag_sizes[parent], primes);
+        pending[parent] = pending[parent] ? td_join(pending[parent], table, primes) : table;
+    }
+
+    for (int v = 0; v < n; v++)
+    {
+        if (pending[v])
+            free_td_table(pending[v]);
+    }
+
+    free(offsets);
+    free(adjacent);
+    free(order);
+    free(positions);
+    free(bags);
+    free(bag_sizes);
+    free(pending);
+    return success;
+}
+
+bool count_hists_td(Graph *graph, BigNat *count)
+{
+    EdgeList edge_list;
+    edge_list.vertices = graph->vertices;
+    edge_list.edges = 0;
+    edge_list.origins = malloc((graph->edges + 1) * sizeof(int));
+    edge_list.destinations = malloc((graph->edges + 1) * sizeof(int));
+
+    if (edge_list.origins == NULL || edge_list.destinations == NULL)
+    {
+        fprintf(stderr, "Failed to allocate edge list.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int u = 0; u < graph->vertices; u++)
+    {
+        for (int v = u + 1; v < graph->vertices; v++)
+        {
+            if (graph->adjacency_matrix[u] & (FIRST_BIT >> v))
+            {
+                edge_list.origins[edge_list.edges] = u;
+                edge_list.destinations[edge_list.edges] = v;
+                edge_list.edges++;
+            }
+        }
+    }
+
+    // There are at most as many HISTs as spanning trees, all primes are larger than 2^61
+    int nb_primes = spanning_tree_bits(graph) / 61 + 1;
+
+    uint64_t residues[NB_MODULAR_PRIMES];
+    bool success = count_hists_td_mod(&edge_list, MODULAR_PRIMES, nb_primes, residues, TD_MAX_GRAPH_BAG);
+
+    if (success)
+        *count = bignat_from_residues(residues, MODULAR_PRIMES, nb_primes);
+
+    free_edge_list(&edge_list);
+    return success;
+}
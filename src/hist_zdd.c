@@ -0,0 +1,697 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <hist_zdd.h>
+
+// Frontier state of a vertex in one byte: the component label in the high 6 bits and the capped tree degree in the low 2
+#define ZDD_STATE(component, degree) ((uint8_t)(((component) << 2) | (degree)))
+#define ZDD_COMPONENT(state) ((state) >> 2)
+#define ZDD_DEGREE(state) ((state) & 3)
+
+/*
+ * Nodes of one level during construction, identified by their frontier states.
+ * All nodes of a level have consecutive indices starting at first_node.
+ */
+typedef struct ZddLevel
+{
+    int first_node;
+    int nb_nodes;
+    // Number of frontier vertices, the length of every state
+    int width;
+    uint8_t *states;
+    int capacity;
+    // Open addressing on the states, -1 marks an empty slot
+    int *slots;
+    int nb_slots;
+} ZddLevel;
+
+void zl_init(ZddLevel *level, int first_node, int width)
+{
+    level->first_node = first_node;
+    level->nb_nodes = 0;
+    level->width = width;
+    level->capacity = 64;
+    level->states = malloc(level->capacity * (width + 1));
+    level->nb_slots = 128;
+    level->slots = malloc(level->nb_slots * sizeof(int));
+
+    if (level->states == NULL || level->slots == NULL)
+    {
+        fprintf(stderr, "Failed to allocate ZDD level.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    memset(level->slots, -1, level->nb_slots * sizeof(int));
+}
+
+void free_zl(ZddLevel *level)
+{
+    free(level->states);
+    free(level->slots);
+}
+
+uint64_t zl_hash(const uint8_t *state, int width)
+{
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (int i = 0; i < width; i++)
+        hash = (hash ^ state[i]) * 0x100000001b3ULL;
+
+    return hash ^ (hash >> 29);
+}
+
+int zl_find_slot(ZddLevel *level, const uint8_t *state)
+{
+    int mask = level->nb_slots - 1;
+    int slot = zl_hash(state, level->width) & mask;
+
+    while (level->slots[slot] >= 0)
+    {
+        if (memcmp(&level->states[level->slots[slot] * level->width], state, level->width) == 0)
+            break;
+        slot = (slot + 1) & mask;
+    }
+
+    return slot;
+}
+
+// Index of the node with the given state, created if needed
+int zl_node(ZddLevel *level, const uint8_t *state)
+{
+    int slot = zl_find_slot(level, state);
+    if (level->slots[slot] >= 0)
+        return level->first_node + level->slots[slot];
+
+    if (level->nb_nodes == level->capacity)
+    {
+        level->capacity *= 2;
+        level->states = realloc(level->states, level->capacity * (level->width + 1));
+
+        if (level->states == NULL)
+        {
+            fprintf(stderr, "Failed to grow ZDD level.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    int index = level->nb_nodes++;
+    memcpy(&level->states[index * level->width], state, level->width);
+    level->slots[slot] = index;
+
+    if (2 * level->nb_nodes > level->nb_slots)
+    {
+        free(level->slots);
+        level->nb_slots *= 2;
+        level->slots = malloc(level->nb_slots * sizeof(int));
+
+        if (level->slots == NULL)
+        {
+            fprintf(stderr, "Failed to grow ZDD level.\n");
+            exit(EXIT_FAILURE);
+        }
+
+        memset(level->slots, -1, level->nb_slots * sizeof(int));
+        for (int i = 0; i < level->nb_nodes; i++)
+            level->slots[zl_find_slot(level, &level->states[i * level->width])] = i;
+    }
+
+    return level->first_node + index;
+}
+
+// Everything the construction needs to know about the edge order
+typedef struct ZddFrontiers
+{
+    int nb_edges;
+    Edge *edges;
+    // Vertices with both decided and undecided edges when edge i is decided, including its endpoints
+    uint64_t *frontiers;
+    // Vertices whose first edge is edge i
+    uint64_t *entering;
+    // True once every vertex has been entered
+    bool *all_entered;
+} ZddFrontiers;
+
+// Child of a node when the edge is left out or added, or a terminal if the frontier decides the outcome
+int zdd_child(ZddFrontiers *frontiers, int level, uint8_t *states, bool add_edge, ZddLevel *next)
+{
+    uint64_t frontier = frontiers->frontiers[level];
+    Edge *edge = &frontiers->edges[level];
+
+    // Vertex indexed copy of the state, components are numbered below 64
+    uint8_t components[64] = {0};
+    uint8_t degrees[64] = {0};
+
+    int i = 0;
+    for (uint64_t rest = frontier; rest; rest &= ~(FIRST_BIT >> first_bit_position(rest)))
+    {
+        int vertex = first_bit_position(rest);
+        components[vertex] = ZDD_COMPONENT(states[i]);
+        degrees[vertex] = ZDD_DEGREE(states[i]);
+        i++;
+    }
+
+    if (add_edge)
+    {
+        int kept = components[edge->origin];
+        int merged = components[edge->destination];
+
+        if (kept == merged)
+            return ZDD_EMPTY;
+
+        for (uint64_t rest = frontier; rest; rest &= ~(FIRST_BIT >> first_bit_position(rest)))
+        {
+            int vertex = first_bit_position(rest);
+            if (components[vertex] == merged)
+                components[vertex] = kept;
+        }
+
+        if (degrees[edge->origin] < 3)
+            degrees[edge->origin]++;
+        if (degrees[edge->destination] < 3)
+            degrees[edge->destination]++;
+    }
+
+    // Vertices without undecided edges have their final degree. A component without
+    // frontier vertices is finished, which only gives a HIST if it covers every vertex.
+    uint64_t remaining = frontier;
+    uint64_t leaving = level + 1 < frontiers->nb_edges ? frontier & ~frontiers->frontiers[level + 1] : frontier;
+
+    for (uint64_t rest = leaving; rest; rest &= ~(FIRST_BIT >> first_bit_position(rest)))
+    {
+        int vertex = first_bit_position(rest);
+        remaining &= ~(FIRST_BIT >> vertex);
+
+        if (degrees[vertex] == 0 || degrees[vertex] == 2)
+            return ZDD_EMPTY;
+
+        bool shared = false;
+        for (uint64_t others = remaining; others && !shared; others &= ~(FIRST_BIT >> first_bit_position(others)))
+            shared = components[first_bit_position(others)] == components[vertex];
+
+        if (!shared)
+            return remaining == 0 && frontiers->all_entered[level] ? ZDD_UNIT : ZDD_EMPTY;
+    }
+
+    // The last edge always finishes the tree or fails
+    if (level + 1 == frontiers->nb_edges)
+        return ZDD_EMPTY;
+
+    uint64_t next_frontier = frontiers->frontiers[level + 1];
+    uint8_t next_states[64];
+    int mapping[128];
+    memset(mapping, -1, sizeof(mapping));
+
+    int next_label = 0;
+    i = 0;
+    for (uint64_t rest = next_frontier; rest; rest &= ~(FIRST_BIT >> first_bit_position(rest)))
+    {
+        int vertex = first_bit_position(rest);
+        bool entering = frontiers->entering[level + 1] & (FIRST_BIT >> vertex);
+
+        // Entering vertices are isolated, labels are renumbered in order of first appearance
+        int label = entering ? 64 + vertex : components[vertex];
+        int degree = entering ? 0 : degrees[vertex];
+
+        if (mapping[label] < 0)
+            mapping[label] = next_label++;
+
+        next_states[i++] = ZDD_STATE(mapping[label], degree);
+    }
+
+    return zl_node(next, next_states);
+}
+
+int zdd_edge_order(AdjListGraph *graph, Edge *edges)
+{
+    int n = graph->vertices;
+    int positions[64];
+    int queue[64];
+    int nb_queued = 0;
+
+    for (int v = 0; v < n; v++)
+        positions[v] = -1;
+
+    int start = first_bit_position(graph->available_vertices);
+    positions[start] = 0;
+    queue[nb_queued++] = start;
+
+    for (int head = 0; head < nb_queued; head++)
+    {
+        int vertex = queue[head];
+        AdjListNeighbourArray *neighbours = &graph->neighbours[vertex];
+
+        for (unsigned int i = 0; i < neighbours->size; i++)
+        {
+            AdjListNeighbour *neighbour = &neighbours->neighbours[i];
+            if (neighbour->edge->removed || positions[neighbour->vertex] >= 0)
+                continue;
+
+            positions[neighbour->vertex] = nb_queued;
+            queue[nb_queued++] = neighbour->vertex;
+        }
+    }
+
+    if (nb_queued < graph->nb_available_vertices)
+        return -1;
+
+    // Sort keys: earliest endpoint, then latest endpoint, then the index of the edge
+    int nb_edges = 0;
+    uint32_t *keys = malloc((graph->edges->size + 1) * sizeof(uint32_t));
+
+    for (unsigned int e = 0; e < graph->edges->size; e++)
+    {
+        AdjListEdge *edge = &graph->edges->edges[e];
+        if (edge->removed)
+            continue;
+
+        int a = positions[edge->origin];
+        int b = positions[edge->destination];
+        uint32_t first = a < b ? a : b;
+        uint32_t last = a < b ? b : a;
+        keys[nb_edges++] = (first << 18) | (last << 12) | e;
+    }
+
+    // Insertion sort, there are at most 2016 edges
+    for (int i = 1; i < nb_edges; i++)
+    {
+        uint32_t key = keys[i];
+        int j = i;
+        for (; j > 0 && keys[j - 1] > key; j--)
+            keys[j] = keys[j - 1];
+        keys[j] = key;
+    }
+
+    for (int i = 0; i < nb_edges; i++)
+    {
+        AdjListEdge *edge = &graph->edges->edges[keys[i] & 4095];
+        edges[i].origin = edge->origin;
+        edges[i].destination = edge->destination;
+    }
+
+    free(keys);
+    return nb_edges;
+}
+
+bool zdd_order_edges(AdjListGraph *graph, ZddFrontiers *frontiers)
+{
+    frontiers->edges = malloc((graph->edges->size + 1) * sizeof(Edge));
+    frontiers->nb_edges = zdd_edge_order(graph, frontiers->edges);
+
+    if (frontiers->nb_edges < 0)
+    {
+        free(frontiers->edges);
+        return false;
+    }
+
+    return true;
+}
+
+void zdd_compute_frontiers(ZddFrontiers *frontiers, int n)
+{
+    int m = frontiers->nb_edges;
+    int first[64];
+    int last[64];
+
+    for (int v = 0; v < n; v++)
+        first[v] = last[v] = -1;
+
+    for (int i = 0; i < m; i++)
+    {
+        int endpoints[2] = {frontiers->edges[i].origin, frontiers->edges[i].destination};
+        for (int j = 0; j < 2; j++)
+        {
+            if (first[endpoints[j]] < 0)
+                first[endpoints[j]] = i;
+            last[endpoints[j]] = i;
+        }
+    }
+
+    frontiers->frontiers = calloc(m, sizeof(uint64_t));
+    frontiers->entering = calloc(m, sizeof(uint64_t));
+    frontiers->all_entered = calloc(m, sizeof(bool));
+
+    int last_entry = 0;
+    for (int v = 0; v < n; v++)
+    {
+        if (first[v] < 0)
+            continue;
+
+        if (first[v] > last_entry)
+            last_entry = first[v];
+
+        frontiers->entering[first[v]] |= FIRST_BIT >> v;
+        for (int i = first[v]; i <= last[v]; i++)
+            frontiers->frontiers[i] |= FIRST_BIT >> v;
+    }
+
+    for (int i = last_entry; i < m; i++)
+        frontiers->all_entered[i] = true;
+}
+
+HistZdd *zdd_new(unsigned int vertices, ZddFrontiers *frontiers)
+{
+    HistZdd *zdd = malloc(sizeof(HistZdd));
+
+    if (zdd == NULL)
+    {
+        fprintf(stderr, "Failed to allocate ZDD.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    zdd->vertices = vertices;
+    zdd->nb_edges = frontiers ? frontiers->nb_edges : 0;
+    zdd->edges = frontiers ? frontiers->edges : NULL;
+    zdd->nodes = NULL;
+    zdd->nb_nodes = 2;
+    zdd->counts = NULL;
+    return zdd;
+}
+
+// Shares equal nodes and removes nodes whose edge can never be added, then counts the HISTs below every node.
+// Construction nodes are indexed by level, so children always have larger indices than their parents.
+void zdd_reduce(HistZdd *zdd, int nb_built, int *levels, int *los, int *his)
+{
+    int *representatives = malloc(nb_built * sizeof(int));
+    int nb_slots = 1;
+    while (nb_slots < 2 * nb_built)
+        nb_slots *= 2;
+    int *slots = malloc(nb_slots * sizeof(int));
+
+    zdd->nodes = malloc(nb_built * sizeof(ZddNode));
+    zdd->counts = malloc(nb_built * sizeof(BigNat));
+
+    if (representatives == NULL || slots == NULL || zdd->nodes == NULL || zdd->counts == NULL)
+    {
+        fprintf(stderr, "Failed to allocate ZDD reduction.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    memset(slots, -1, nb_slots * sizeof(int));
+
+    for (int terminal = 0; terminal < 2; terminal++)
+    {
+        representatives[terminal] = terminal;
+        zdd->nodes[terminal].edge = zdd->nb_edges;
+        zdd->nodes[terminal].lo = zdd->nodes[terminal].hi = terminal;
+        zdd->counts[terminal] = bignat_from_u64(terminal);
+    }
+
+    zdd->nb_nodes = 2;
+
+    for (int node = nb_built - 1; node >= 2; node--)
+    {
+        int lo = representatives[los[node]];
+        int hi = representatives[his[node]];
+
+        if (hi == ZDD_EMPTY)
+        {
+            representatives[node] = lo;
+            continue;
+        }
+
+        uint64_t hash = ((uint64_t)levels[node] * 0x9e3779b97f4a7c15ULL) ^ ((uint64_t)lo * 0xc2b2ae3d27d4eb4fULL) ^ ((uint64_t)hi * 0x165667b19e3779f9ULL);
+        int slot = (hash ^ (hash >> 32)) & (nb_slots - 1);
+
+        while (slots[slot] >= 0)
+        {
+            ZddNode *other = &zdd->nodes[slots[slot]];
+            if (other->edge == levels[node] && other->lo == lo && other->hi == hi)
+                break;
+            slot = (slot + 1) & (nb_slots - 1);
+        }
+
+        if (slots[slot] < 0)
+        {
+            int index = zdd->nb_nodes++;
+            zdd->nodes[index].edge = levels[node];
+            zdd->nodes[index].lo = lo;
+            zdd->nodes[index].hi = hi;
+            zdd->counts[index] = zdd->counts[lo];
+            bignat_add(&zdd->counts[index], &zdd->counts[hi]);
+            slots[slot] = index;
+        }
+
+        representatives[node] = slots[slot];
+    }
+
+    zdd->root = nb_built > 2 ? representatives[2] : ZDD_EMPTY;
+
+    free(representatives);
+    free(slots);
+}
+
+HistZdd *zdd_build(AdjListGraph *graph)
+{
+    ZddFrontiers frontiers;
+    HistZdd *zdd;
+
+    // The empty graph has no HISTs and a single vertex is one, other graphs need every vertex in the tree
+    if (graph->nb_available_vertices <= 1 || !zdd_order_edges(graph, &frontiers) || frontiers.nb_edges == 0)
+    {
+        zdd = zdd_new(graph->vertices, NULL);
+        int root = graph->nb_available_vertices == 1 ? ZDD_UNIT : ZDD_EMPTY;
+        zdd_reduce(zdd, 2, NULL, NULL, NULL);
+        zdd->root = root;
+        return zdd;
+    }
+
+    zdd_compute_frontiers(&frontiers, graph->vertices);
+
+    int capacity = 1024;
+    int *levels = malloc(capacity * sizeof(int));
+    int *los = malloc(capacity * sizeof(int));
+    int *his = malloc(capacity * sizeof(int));
+
+    // The root: both endpoints of the first edge are isolated
+    ZddLevel current;
+    zl_init(&current, 2, 2);
+    uint8_t root_states[2] = {ZDD_STATE(0, 0), ZDD_STATE(1, 0)};
+    zl_node(&current, root_states);
+
+    bool too_large = false;
+
+    for (int level = 0; level < frontiers.nb_edges && !too_large; level++)
+    {
+        int next_first_node = current.first_node + current.nb_nodes;
+
+        ZddLevel next;
+        zl_init(&next, next_first_node, level + 1 < frontiers.nb_edges ? count_set_bits(frontiers.frontiers[level + 1]) : 0);
+
+        if (next_first_node > capacity)
+        {
+            while (next_first_node > capacity)
+                capacity *= 2;
+
+            levels = realloc(levels, capacity * sizeof(int));
+            los = realloc(los, capacity * sizeof(int));
+            his = realloc(his, capacity * sizeof(int));
+
+            if (levels == NULL || los == NULL || his == NULL)
+            {
+                fprintf(stderr, "Failed to grow ZDD.\n");
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        for (int i = 0; i < current.nb_nodes; i++)
+        {
+            int node = current.first_node + i;
+            uint8_t *states = &current.states[i * current.width];
+
+            levels[node] = level;
+            los[node] = zdd_child(&frontiers, level, states, false, &next);
+            his[node] = zdd_child(&frontiers, level, states, true, &next);
+
+            if (next.first_node + next.nb_nodes > ZDD_MAX_NODES)
+            {
+                too_large = true;
+                break;
+            }
+        }
+
+        free_zl(&current);
+        current = next;
+    }
+
+    int nb_built = current.first_node + current.nb_nodes;
+    free_zl(&current);
+
+    free(frontiers.frontiers);
+    free(frontiers.entering);
+    free(frontiers.all_entered);
+
+    if (too_large)
+    {
+        free(frontiers.edges);
+        zdd = NULL;
+    }
+    else
+    {
+        zdd = zdd_new(graph->vertices, &frontiers);
+        zdd_reduce(zdd, nb_built, levels, los, his);
+    }
+
+    free(levels);
+    free(los);
+    free(his);
+    return zdd;
+}
+
+HistZdd *zdd_from_graph(Graph *graph)
+{
+    AdjListGraph *alg = alg_from_graph_and_hidden(graph, 0);
+    HistZdd *zdd = zdd_build(alg);
+    free_alg(alg);
+    return zdd;
+}
+
+void free_zdd(HistZdd *zdd)
+{
+    free(zdd->edges);
+    free(zdd->nodes);
+    free(zdd->counts);
+    free(zdd);
+}
+
+BigNat zdd_count(HistZdd *zdd)
+{
+    return zdd->counts[zdd->root];
+}
+
+void zdd_edge_counts(HistZdd *zdd, BigNat *counts)
+{
+    for (int e = 0; e < zdd->nb_edges; e++)
+        counts[e] = bignat_from_u64(0);
+
+    // Number of paths from the root to every node, parents come after their children
+    BigNat *paths = calloc(zdd->nb_nodes, sizeof(BigNat));
+
+    if (paths == NULL)
+    {
+        fprintf(stderr, "Failed to allocate ZDD paths.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    paths[zdd->root] = bignat_from_u64(1);
+
+    for (int node = zdd->root; node >= 2; node--)
+    {
+        if (bignat_is_zero(&paths[node]))
+            continue;
+
+        ZddNode *current = &zdd->nodes[node];
+        bignat_add(&paths[current->lo], &paths[node]);
+        bignat_add(&paths[current->hi], &paths[node]);
+
+        BigNat with_edge = paths[node];
+        bignat_mul(&with_edge, &zdd->counts[current->hi]);
+        bignat_add(&counts[current->edge], &with_edge);
+    }
+
+    free(paths);
+}
+
+void zdd_unrank(HistZdd *zdd, BigNat *rank, Graph *tree)
+{
+    BigNat rest = *rank;
+
+    for (unsigned int v = 0; v < tree->vertices; v++)
+        tree->adjacency_matrix[v] = 0;
+    tree->edges = 0;
+
+    int node = zdd->root;
+    while (node >= 2)
+    {
+        ZddNode *current = &zdd->nodes[node];
+
+        if (bignat_compare(&rest, &zdd->counts[current->lo]) < 0)
+        {
+            node = current->lo;
+            continue;
+        }
+
+        bignat_sub(&rest, &zdd->counts[current->lo]);
+        add_edge_to_graph(tree, &zdd->edges[current->edge]);
+        node = current->hi;
+    }
+}
+
+bool zdd_rank(HistZdd *zdd, Graph *tree, BigNat *rank)
+{
+    *rank = bignat_from_u64(0);
+
+    if (tree->vertices != zdd->vertices)
+        return false;
+
+    unsigned int tree_edges = 0;
+    for (unsigned int v = 0; v < tree->vertices; v++)
+        tree_edges += vertex_degree(tree->adjacency_matrix[v]);
+    tree_edges /= 2;
+
+    unsigned int found_edges = 0;
+    int node = zdd->root;
+
+    while (node >= 2)
+    {
+        ZddNode *current = &zdd->nodes[node];
+        Edge *edge = &zdd->edges[current->edge];
+
+        if (tree->adjacency_matrix[edge->origin] & (FIRST_BIT >> edge->destination))
+        {
+            bignat_add(rank, &zdd->counts[current->lo]);
+            found_edges++;
+            node = current->hi;
+        }
+        else
+        {
+            node = current->lo;
+        }
+    }
+
+    // Edges skipped by the diagram are not in any HIST reached this way
+    return node == ZDD_UNIT && found_edges == tree_edges;
+}
+
+uint64_t zdd_random(uint64_t *seed)
+{
+    // splitmix64
+    uint64_t z = (*seed += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+void zdd_sample(HistZdd *zdd, uint64_t *seed, Graph *tree)
+{
+    BigNat *count = &zdd->counts[zdd->root];
+
+    int top = BIGNAT_LIMBS - 1;
+    while (top > 0 && count->limbs[top] == 0)
+        top--;
+
+    int bits = 64 - __builtin_clzll(count->limbs[top]);
+    uint64_t top_mask = bits == 64 ? ~0ULL : (1ULL << bits) - 1;
+
+    // Rejection sampling below the next power of two, accepted with probability at least one half
+    BigNat rank;
+    do
+    {
+        rank = bignat_from_u64(0);
+        for (int i = 0; i < top; i++)
+            rank.limbs[i] = zdd_random(seed);
+        rank.limbs[top] = zdd_random(seed) & top_mask;
+    } while (bignat_compare(&rank, count) >= 0);
+
+    zdd_unrank(zdd, &rank, tree);
+}
+
+bool count_hists_zdd(Graph *graph, BigNat *count)
+{
+    HistZdd *zdd = zdd_from_graph(graph);
+
+    if (zdd == NULL)
+        return false;
+
+    *count = zdd_count(zdd);
+    free_zdd(zdd);
+    return true;
+}
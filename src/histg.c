@@ -4,9 +4,22 @@
 #include <argp.h>
 #include <math.h>
 #include <string.h>
+#include <limits.h>
 
 #include <histg_lib.h>
 #include <kirchhoff.h>
+#include <kirchhoff_batch.h>
+#include <sparse_laplacian.h>
+#include <modular.h>
+#include <hist_algebraic.h>
+#include <hist_treewidth.h>
+#include <hist_zdd.h>
+#include <hist_components.h>
+#include <hist_blocks.h>
+#include <hist_kernel.h>
+#include <hist_exists.h>
+#include <hist_table.h>
+#include <relabel.h>
 #include <adjlist.h>
 
 const char *argp_program_version = "histg 0.1.0";
@@ -25,6 +38,16 @@ static struct argp_option options[] = {
     {"hist", 'h', 0, 0, "Calculate homeomorphically irreducible spanning trees, this is the default option"},
     {"spanning", 's', 0, 0, "Calculate regular spanning trees instead of homeomorphically irreducible spanning trees"},
     {"hypohist", 'y', 0, 0, "Calculate wether the graph is hypohisterian or not"},
+    {"edge-list", 'l', 0, 0, "Read graphs as edge lists: a line 'n m' followed by m lines 'u v'. Outputs the natural logarithm of the number of spanning trees and the number modulo 2^62 - 57, left empty in the rare case that the elimination meets a pivot divisible by it, with engine td also the number of HISTs modulo 2^62 - 57"},
+    {"engine", 'E', "ENGINE", 0, "HIST counting engine: search (default), td (tree decomposition, zdd for wider graphs), zdd, components (component caching), blocks (block-cut tree) or table (labeled HIST table, up to 9 vertices). Other engines only count, enumeration and graphs they cannot handle use search"},
+    {"branching", 'B', "STRATEGY", 0, "Branching strategy of the HIST search: min-degree (default), index, constrained (fewest undecided edges), grow (tree degree 2 first), risk (likely tree degree 2 first) or weighted (most failures per undecided edge)"},
+    {"relabel", 'r', "ORDER", 0, "Relabel every graph before the searches: none (default), degeneracy (densest core first), bfs (highest degree first, then breadth first by degree, as winter does) or cuthill-mckee. Enumerated trees use the original labels"},
+    {"check-algebraic", 'a', 0, 0, "Verify every HIST count against an interpolation over the vertex degrees that shares no code with the searches, and stop at the first mismatch. Only sparse graphs are checked, the interpolation takes as many determinants as the product of the vertex degrees and gives up beyond 2^22"},
+    {"kernelize", 'k', 0, 0, "Reduce every graph before the HIST search: edges between vertices of degree at most 2 are removed, every pendant edge is forced into the tree, and of the pendant vertices at the same vertex three are kept while the rest are removed and added back to every tree. Enumerated trees use the original labels"},
+    {"deletions", 'd', 0, 0, "Calculate the number of spanning trees after deleting each edge, ordered by origin and then destination, and after deleting each vertex. Counts are space separated"},
+    {"edge-hists", 'x', 0, 0, "Calculate the number of HISTs containing each edge, ordered by origin and then destination, from a ZDD of all HISTs. Counts are space separated"},
+    {"sample", 'S', "N", 0, "Output N uniformly random HISTs of every graph, drawn from a ZDD of all HISTs"},
+    {"unrank", 'u', "K", 0, "Output the HIST of rank K, counting from 0 in the order of the ZDD of all HISTs, for every graph that has one"},
     {"enumerate", 'e', "FILE", OPTION_ARG_OPTIONAL, "Output calculated trees to given file or default output otherwise"},
     {"positives", 'p', 0, 0, "Only output when the number of found spanning trees/hists/hypohists is at least one"},
     {"negatives", 'n', 0, 0, "Only output when the number of found spanning trees/hists/hypohists is zero"},
@@ -36,16 +59,33 @@ static struct argp_option options[] = {
     {0},
 };
 
+typedef enum HistEngine
+{
+    EngineSearch,
+    EngineTreeDecomposition,
+    EngineZdd,
+    EngineComponents,
+    EngineBlocks,
+    EngineTable,
+} HistEngine;
+
 struct arguments
 {
     bool quiet, enumerate, positives, negatives;
-    bool spanning, hist, hypohist;
+    bool spanning, hist, hypohist, deletions;
+    bool edge_list;
+    bool edge_hists, unrank;
+    unsigned long long int nb_samples;
+    BigNat unrank_rank;
     bool timing, header, echo;
-    bool boolean;
+    bool boolean, kernelize, check_algebraic;
     char *output_file;
     char *input_file;
     char *enumerate_file;
     Format format;
+    HistEngine engine;
+    Relabeling relabeling;
+    const HistBranching *branching;
 };
 
 // Parse a single argument
@@ -74,6 +114,66 @@ static error_t parse_opt(int key, char *arg, struct argp_state *state)
     case 'y':
         arguments->hypohist = true;
         break;
+    case 'd':
+        arguments->deletions = true;
+        break;
+    case 'l':
+        arguments->edge_list = true;
+        break;
+    case 'E':
+        if (strcmp(arg, "search") == 0)
+            arguments->engine = EngineSearch;
+        else if (strcmp(arg, "td") == 0)
+            arguments->engine = EngineTreeDecomposition;
+        else if (strcmp(arg, "zdd") == 0)
+            arguments->engine = EngineZdd;
+        else if (strcmp(arg, "components") == 0)
+            arguments->engine = EngineComponents;
+        else if (strcmp(arg, "blocks") == 0)
+            arguments->engine = EngineBlocks;
+        else if (strcmp(arg, "table") == 0)
+            arguments->engine = EngineTable;
+        else
+        {
+            fprintf(stderr, "Unknown engine: %s\n", arg);
+            exit(EXIT_FAILURE);
+        }
+        break;
+    case 'B':
+        arguments->branching = hist_branching_by_name(arg);
+        if (arguments->branching == NULL)
+        {
+            fprintf(stderr, "Unknown branching strategy: %s\n", arg);
+            exit(EXIT_FAILURE);
+        }
+        break;
+    case 'r':
+        if (!relabeling_from_name(arg, &arguments->relabeling))
+        {
+            fprintf(stderr, "Unknown vertex order: %s\n", arg);
+            exit(EXIT_FAILURE);
+        }
+        break;
+    case 'x':
+        arguments->edge_hists = true;
+        break;
+    case 'k':
+        arguments->kernelize = true;
+        break;
+    case 'a':
+        arguments->check_algebraic = true;
+        break;
+    case 'S':
+        arguments->nb_samples = strtoull(arg, NULL, 10);
+        break;
+    case 'u':
+        if (!bignat_from_string(arg, &arguments->unrank_rank))
+        {
+            fprintf(stderr, "Invalid rank: %s\n", arg);
+            exit(EXIT_FAILURE);
+        }
+        arguments->unrank = true;
+        break;
     case 'e':
         arguments->enumerate = true;
         arguments->enumerate_file = arg;
@@ -157,6 +257,22 @@ void print_header(struct arguments *arguments, FILE *output)
             fprintf(output, "hypohist");
         }
 
+        if (arguments->deletions)
+        {
+            if (arguments->spanning || arguments->hist || arguments->hypohist)
+                fprintf(output, ",");
+
+            fprintf(output, "edge_deletions,vertex_deletions");
+        }
+
+        if (arguments->edge_hists)
+        {
+            if (arguments->spanning || arguments->hist || arguments->hypohist || arguments->deletions)
+                fprintf(output, ",");
+
+            fprintf(output, "edge_hists");
+        }
+
         fprintf(output, "\n");
     }
 }
@@ -178,14 +294,254 @@ bool should_print(struct arguments *arguments, unsigned long long int nb_spannin
     return false;
 }
 
+// Counts beyond 64 bits are only printed exactly, everywhere else they saturate
+unsigned long long int saturated_count(BigNat *count)
+{
+    uint64_t small_count;
+    return bignat_to_u64(count, &small_count) ? small_count : ULLONG_MAX;
+}
+
+void add_saturated(unsigned long long int *total, unsigned long long int count)
+{
+    *total = *total > ULLONG_MAX - count ? ULLONG_MAX : *total + count;
+}
+
+// Counts and prints the spanning trees of the pending graphs, which all have the same number of vertices
+void flush_spanning_batch(struct arguments *arguments, FILE *output, LaplacianBatch *batch, Graph **graphs, int *nb_graphs, unsigned long long int *total_nb_spanning_trees)
+{
+    BigNat counts[KIRCHHOFF_BATCH_SIZE];
+    kirchhoff_exact_batch(batch, graphs, *nb_graphs, counts);
+
+    for (int i = 0; i < *nb_graphs; i++)
+    {
+        char output_str[1024] = "";
+        char output_str_temp[512] = "";
+
+        if (arguments->echo)
+        {
+            char *g6string = get_graph6_string(graphs[i]);
+            sprintf(output_str_temp, "%s,", g6string);
+            strcat(output_str, output_str_temp);
+            free(g6string);
+        }
+
+        unsigned long long int nb_spanning_trees = saturated_count(&counts[i]);
+        add_saturated(total_nb_spanning_trees, nb_spanning_trees);
+
+        bignat_to_string(&counts[i], output_str_temp);
+        strcat(output_str, output_str_temp);
+        strcat(output_str, "\n");
+
+        if (should_print(arguments, nb_spanning_trees, 0, 0))
+            fputs(output_str, output);
+
+        free_graph(graphs[i]);
+    }
+
+    *nb_graphs = 0;
+}
+
+// Counts HISTs with one of the counting engines, returns false if the engine cannot handle the graph
+bool count_hists_with_engine(HistEngine engine, Graph *graph, BigNat *count)
+{
+    switch (engine)
+    {
+    case EngineTreeDecomposition:
+        // Graphs too wide for the decomposition often still have a small diagram
+        return count_hists_td(graph, count) || count_hists_zdd(graph, count);
+    case EngineZdd:
+        return count_hists_zdd(graph, count);
+    case EngineComponents:
+        return count_hists_components(graph, count);
+    case EngineBlocks:
+        return count_hists_blocks(graph, count);
+    case EngineTable:
+        return count_hists_table(graph, count);
+    default:
+        return false;
+    }
+}
+
+// Compares a HIST count with the algebraic count, which is only computed for graphs with a small enough degree product
+void check_hists_algebraic(Graph *graph, BigNat *found)
+{
+    BigNat expected;
+
+    if (!count_hists_algebraic(graph, &expected) || bignat_compare(found, &expected) == 0)
+        return;
+
+    char found_str[512];
+    char expected_str[512];
+    bignat_to_string(found, found_str);
+    bignat_to_string(&expected, expected_str);
+
+    fprintf(stderr, "Number of found hists does not match. Graph: \n");
+    fprintf(stderr, "Found: %s, algebraic: %s\n", found_str, expected_str);
+    print_graph_to_output_as_graph6(stderr, graph);
+    exit(EXIT_FAILURE);
+}
+
+// Space separated counts of G - e for every edge followed by a comma and the counts of G - v for every vertex.
+// Rows get long for large graphs, so the string is allocated to fit.
+char *deletions_string(Graph *graph)
+{
+    BigNat *edge_counts = malloc((graph->edges + 1) * sizeof(BigNat));
+    BigNat *vertex_counts = malloc(graph->vertices * sizeof(BigNat));
+    char *result = malloc((graph->edges + graph->vertices + 1) * BIGNAT_STRING_LENGTH);
+
+    if (edge_counts == NULL || vertex_counts == NULL || result == NULL)
+    {
+        fprintf(stderr, "Failed to allocate deletion counts\n");
+        exit(EXIT_FAILURE);
+    }
+
+    kirchhoff_deletions(graph, edge_counts, vertex_counts);
+
+    int length = 0;
+    for (unsigned int e = 0; e < graph->edges; e++)
+    {
+        if (e > 0)
+            result[length++] = ' ';
+        bignat_to_string(&edge_counts[e], result + length);
+        length += strlen(result + length);
+    }
+
+    result[length++] = ',';
+
+    for (unsigned int v = 0; v < graph->vertices; v++)
+    {
+        if (v > 0)
+            result[length++] = ' ';
+        bignat_to_string(&vertex_counts[v], result + length);
+        length += strlen(result + length);
+    }
+
+    result[length] = '\0';
+
+    free(edge_counts);
+    free(vertex_counts);
+    return result;
+}
+
+// Space separated number of HISTs containing each edge, ordered by origin and then destination.
+// Edges the diagram doesn't order, all of them when the graph is disconnected, are in no HIST.
+char *edge_hists_string(HistZdd *zdd, Graph *graph)
+{
+    BigNat *zdd_counts = malloc((zdd->nb_edges + 1) * sizeof(BigNat));
+    char *result = malloc((graph->edges + 1) * BIGNAT_STRING_LENGTH);
+    int(*indices)[64] = malloc(64 * sizeof(*indices));
+
+    if (zdd_counts == NULL || result == NULL || indices == NULL)
+    {
+        fprintf(stderr, "Failed to allocate edge HIST counts\n");
+        exit(EXIT_FAILURE);
+    }
+
+    zdd_edge_counts(zdd, zdd_counts);
+
+    for (unsigned int origin = 0; origin < 64; origin++)
+    {
+        for (unsigned int destination = 0; destination < 64; destination++)
+            indices[origin][destination] = -1;
+    }
+
+    for (int e = 0; e < zdd->nb_edges; e++)
+        indices[zdd->edges[e].origin][zdd->edges[e].destination] = e;
+
+    int length = 0;
+    result[0] = '\0';
+
+    for (unsigned int origin = 0; origin < graph->vertices; origin++)
+    {
+        for (unsigned int destination = origin + 1; destination < graph->vertices; destination++)
+        {
+            if (!(graph->adjacency_matrix[origin] & (FIRST_BIT >> destination)))
+                continue;
+
+            if (length > 0)
+                result[length++] = ' ';
+
+            int index = indices[origin][destination];
+            BigNat zero = bignat_from_u64(0);
+            bignat_to_string(index < 0 ? &zero : &zdd_counts[index], result + length);
+            length += strlen(result + length);
+        }
+    }
+
+    free(zdd_counts);
+    free(indices);
+    return result;
+}
+
+// Spanning tree statistics for graphs given as edge lists, which may be far larger than 64 vertices.
+// The tree decomposition engine also counts HISTs, the other engines need the bitset graphs.
+void run_edge_lists(struct arguments *arguments, FILE *input_file, FILE *output)
+{
+    if (arguments->header)
+    {
+        fprintf(output, "log_spanning_trees,spanning_trees_mod_p");
+        if (arguments->engine == EngineTreeDecomposition)
+            fprintf(output, ",hists_mod_p");
+        if (arguments->timing)
+            fprintf(output, ",spanning_trees_timing");
+        fprintf(output, "\n");
+    }
+
+    Timer timer;
+    Timer full_program_timer;
+    unsigned long long int read_graphs = 0;
+
+    start_timer(&full_program_timer);
+
+    EdgeList edge_list;
+    while (parse_edge_list(input_file, &edge_list))
+    {
+        read_graphs++;
+
+        start_timer(&timer);
+        SparseTreeCount count = sparse_kirchhoff(&edge_list, MODULAR_PRIMES[0]);
+
+        // Left empty when the treewidth is too large
+        uint64_t hists_mod = 0;
+        bool hists_counted = arguments->engine == EngineTreeDecomposition && count_hists_td_mod(&edge_list, MODULAR_PRIMES, 1, &hists_mod, TD_MAX_BAG);
+        end_timer(&timer);
+
+        bool has_trees = count.log_tau > -INFINITY;
+
+        if (!arguments->quiet && ((arguments->positives && has_trees) || (arguments->negatives && !has_trees)))
+        {
+            // Left empty when the elimination hit a pivot divisible by the prime
+            fprintf(output, "%.10f,", count.log_tau);
+            if (count.tau_mod_known)
+                fprintf(output, "%llu", (unsigned long long int)count.tau_mod);
+            if (arguments->engine == EngineTreeDecomposition)
+            {
+                fprintf(output, ",");
+                if (hists_counted)
+                    fprintf(output, "%llu", (unsigned long long int)hists_mod);
+            }
+            if (arguments->timing)
+                fprintf(output, ",%lf", elapsed_time_seconds(&timer));
+            fprintf(output, "\n");
+        }
+
+        free_edge_list(&edge_list);
+    }
+
+    end_timer(&full_program_timer);
+
+    fprintf(stderr, "Found spanning tree counts for %llu graphs in %lf seconds\n", read_graphs, elapsed_time_seconds(&full_program_timer));
+}
+
 int main(int argc, char *argv[])
 {
     struct arguments arguments = {0};
     arguments.format = Graph6;
+    arguments.branching = hist_default_branching;
 
     argp_parse(&argp, argc, argv, 0, 0, &arguments);
 
-    if (!arguments.hist && (!arguments.spanning && !arguments.hypohist))
+    if (!arguments.hist && (!arguments.spanning && !arguments.hypohist && !arguments.deletions && !arguments.edge_hists))
         arguments.hist = true;
 
     if (!arguments.positives && !arguments.negatives)
@@ -196,10 +552,12 @@ int main(int argc, char *argv[])
     Output standard_output;
     standard_output.output_file = stdout;
     standard_output.format = arguments.format;
+    standard_output.labels = NULL;
 
     Output enumerate_output;
     enumerate_output.output_file = NULL;
     enumerate_output.format = arguments.format;
+    enumerate_output.labels = NULL;
     Output *enumerate_output_address = &enumerate_output;
 
     if (arguments.input_file)
@@ -243,6 +601,12 @@ int main(int argc, char *argv[])
         enumerate_output_address = NULL;
     }
 
+    if (arguments.edge_list)
+    {
+        run_edge_lists(&arguments, input_file, standard_output.output_file);
+        exit(EXIT_SUCCESS);
+    }
+
     char *line = NULL;
     size_t length = 0;
     size_t read;
@@ -255,6 +619,18 @@ int main(int argc, char *argv[])
     unsigned long long int total_nb_hypohists = 0;
     Timer full_program_timer;
 
+    AdjListWorkspace *workspace = alw_new();
+
+    // Trees drawn from the ZDD go where enumerated trees would go
+    Output *zdd_tree_output = enumerate_output_address ? enumerate_output_address : &standard_output;
+    uint64_t sample_seed = 0;
+
+    // Plain spanning tree counts are computed for several graphs of the same order at once
+    bool batch_spanning = arguments.spanning && !arguments.enumerate && !arguments.hist && !arguments.hypohist && !arguments.deletions && !arguments.timing && !arguments.edge_hists && arguments.nb_samples == 0 && !arguments.unrank;
+    LaplacianBatch *laplacian_batch = lb_new(64);
+    Graph *pending_graphs[KIRCHHOFF_BATCH_SIZE];
+    int nb_pending_graphs = 0;
+
     print_header(&arguments, standard_output.output_file);
 
     start_timer(&full_program_timer);
@@ -275,6 +651,19 @@ int main(int argc, char *argv[])
         parse_graph6_line(line, graph);
         read_graphs++;
 
+        if (batch_spanning)
+        {
+            if (nb_pending_graphs > 0 && pending_graphs[0]->vertices != graph->vertices)
+                flush_spanning_batch(&arguments, standard_output.output_file, laplacian_batch, pending_graphs, &nb_pending_graphs, &total_nb_spanning_trees);
+
+            pending_graphs[nb_pending_graphs++] = graph;
+
+            if (nb_pending_graphs == KIRCHHOFF_BATCH_SIZE)
+                flush_spanning_batch(&arguments, standard_output.output_file, laplacian_batch, pending_graphs, &nb_pending_graphs, &total_nb_spanning_trees);
+
+            continue;
+        }
+
         unsigned long long int nb_spanning_trees = 0;
         unsigned long long int nb_hists = 0;
         int is_hypoh = 0;
@@ -287,24 +676,39 @@ int main(int argc, char *argv[])
             free(g6string);
         }
 
+        // The searches run on the relabeled graph, everything that prints edges by label on the one read
+        Graph *search_graph = graph;
+        unsigned int labels[64];
+
+        if (arguments.relabeling != RelabelNone)
+        {
+            relabel_order(graph, arguments.relabeling, labels);
+            search_graph = relabel_graph(graph, labels);
+            enumerate_output.labels = labels;
+        }
+
         if (arguments.spanning)
         {
             if (arguments.enumerate)
             {
                 start_timer(&timer);
-                nb_spanning_trees = find_spanning_trees(graph, enumerate_output_address, arguments.boolean);
+                nb_spanning_trees = find_spanning_trees(search_graph, enumerate_output_address, arguments.boolean);
                 end_timer(&timer);
             }
             else
             {
                 start_timer(&timer);
-                nb_spanning_trees = kirchhoff(graph);
+                BigNat exact_spanning_trees = kirchhoff_exact(search_graph);
                 end_timer(&timer);
+
+                nb_spanning_trees = saturated_count(&exact_spanning_trees);
+                bignat_to_string(&exact_spanning_trees, output_str_temp);
             }
 
-            total_nb_spanning_trees += nb_spanning_trees;
+            add_saturated(&total_nb_spanning_trees, nb_spanning_trees);
 
-            sprintf(output_str_temp, "%llu", nb_spanning_trees);
+            if (arguments.enumerate)
+                sprintf(output_str_temp, "%llu", nb_spanning_trees);
             strcat(output_str, output_str_temp);
 
             if (arguments.timing)
@@ -316,27 +720,50 @@ int main(int argc, char *argv[])
 
         if (arguments.hist)
         {
+            BigNat exact_hists;
+            bool counted_by_engine = false;
+
             start_timer(&timer);
             if (arguments.boolean)
             {
                 RunData run_data;
-                find_hists(graph, enumerate_output_address, arguments.boolean, &run_data);
+                if (arguments.kernelize)
+                    find_hists_kernel(search_graph, 0, arguments.branching, enumerate_output_address, arguments.boolean, &run_data);
+                else
+                    hist_exists(search_graph, 0, arguments.branching, enumerate_output_address, &run_data);
                 nb_hists = run_data.hists_this_run;
             }
+            else if (!arguments.enumerate && count_hists_with_engine(arguments.engine, search_graph, &exact_hists))
+            {
+                nb_hists = saturated_count(&exact_hists);
+                counted_by_engine = true;
+            }
             else
             {
                 RunData run_data;
-                find_hists_alg(graph, 0, enumerate_output_address, arguments.boolean, &run_data);
+                if (arguments.kernelize)
+                    find_hists_kernel(search_graph, 0, arguments.branching, enumerate_output_address, arguments.boolean, &run_data);
+                else
+                    find_hists_alg_ws(workspace, search_graph, 0, arguments.branching, enumerate_output_address, arguments.boolean, &run_data);
                 nb_hists = run_data.hists_this_run;
             }
             end_timer(&timer);
 
+            if (arguments.check_algebraic && !arguments.boolean)
+            {
+                BigNat found = counted_by_engine ? exact_hists : bignat_from_u64(nb_hists);
+                check_hists_algebraic(search_graph, &found);
+            }
+
             if (arguments.spanning)
                 strcat(output_str, ",");
 
-            total_nb_hists += nb_hists;
+            add_saturated(&total_nb_hists, nb_hists);
 
-            sprintf(output_str_temp, "%llu", nb_hists);
+            if (counted_by_engine)
+                bignat_to_string(&exact_hists, output_str_temp);
+            else
+                sprintf(output_str_temp, "%llu", nb_hists);
             strcat(output_str, output_str_temp);
 
             if (arguments.timing)
@@ -350,7 +777,10 @@ int main(int argc, char *argv[])
                 if (nb_hists == 0)
                 {
                     RunData run_data;
-                    is_hypoh = is_hypohist_partials(graph, enumerate_output_address, &run_data);
+                    if (arguments.kernelize)
+                        is_hypoh = is_hypohist_kernel(search_graph, arguments.branching, enumerate_output_address, true, &run_data);
+                    else
+                        is_hypoh = is_hypohist_exists(search_graph, arguments.branching, enumerate_output_address, true, &run_data);
                 }
 
                 total_nb_hypohists += is_hypoh;
@@ -362,7 +792,10 @@ int main(int argc, char *argv[])
         else if (arguments.hypohist)
         {
             RunData run_data;
-            is_hypoh = is_hypohist(graph, enumerate_output_address, false, &run_data);
+            if (arguments.kernelize)
+                is_hypoh = is_hypohist_kernel(search_graph, arguments.branching, enumerate_output_address, false, &run_data);
+            else
+                is_hypoh = is_hypohist_exists(search_graph, arguments.branching, enumerate_output_address, false, &run_data);
 
             total_nb_hypohists += is_hypoh;
 
@@ -370,16 +803,93 @@ int main(int argc, char *argv[])
             strcat(output_str, output_str_temp);
         }
 
-        strcat(output_str, "\n");
+        if (search_graph != graph)
+        {
+            free_graph(search_graph);
+            enumerate_output.labels = NULL;
+        }
+
+        char *deletions_str = NULL;
+
+        if (arguments.deletions)
+        {
+            if (arguments.spanning || arguments.hist || arguments.hypohist)
+                strcat(output_str, ",");
+
+            deletions_str = deletions_string(graph);
+        }
+
+        char *edge_hists_str = NULL;
+
+        if (arguments.edge_hists || arguments.nb_samples > 0 || arguments.unrank)
+        {
+            HistZdd *zdd = zdd_from_graph(graph);
+
+            if (zdd == NULL)
+                fprintf(stderr, "ZDD of graph %llu is too large\n", read_graphs);
+
+            if (zdd && arguments.edge_hists)
+                edge_hists_str = edge_hists_string(zdd, graph);
+
+            if (zdd && !bignat_is_zero(&zdd->counts[zdd->root]))
+            {
+                Graph *tree = empty_graph(graph->vertices);
+
+                for (unsigned long long int i = 0; i < arguments.nb_samples; i++)
+                {
+                    zdd_sample(zdd, &sample_seed, tree);
+                    print_graph_to_output(zdd_tree_output, tree);
+                }
+
+                if (arguments.unrank && bignat_compare(&arguments.unrank_rank, &zdd->counts[zdd->root]) < 0)
+                {
+                    zdd_unrank(zdd, &arguments.unrank_rank, tree);
+                    print_graph_to_output(zdd_tree_output, tree);
+                }
+
+                free_graph(tree);
+            }
+
+            if (zdd)
+                free_zdd(zdd);
+        }
 
         if (should_print(&arguments, nb_spanning_trees, nb_hists, is_hypoh))
+        {
             fputs(output_str, standard_output.output_file);
+            if (deletions_str)
+                fputs(deletions_str, standard_output.output_file);
+            if (arguments.edge_hists)
+            {
+                if (arguments.spanning || arguments.hist || arguments.hypohist || arguments.deletions)
+                    fputs(",", standard_output.output_file);
+                if (edge_hists_str)
+                    fputs(edge_hists_str, standard_output.output_file);
+            }
+            fputs("\n", standard_output.output_file);
+        }
+
+        free(deletions_str);
+        free(edge_hists_str);
 
         free_graph(graph);
     }
 
+    if (nb_pending_graphs > 0)
+        flush_spanning_batch(&arguments, standard_output.output_file, laplacian_batch, pending_graphs, &nb_pending_graphs, &total_nb_spanning_trees);
+
     end_timer(&full_program_timer);
 
+    free_alw(workspace);
+    free_lb(laplacian_batch);
+
+    // -d and -x on their own count nothing that adds up over the graphs
+    if (!arguments.spanning && !arguments.hist && !arguments.hypohist)
+    {
+        fprintf(stderr, "Processed %llu graphs in %lf seconds\n", read_graphs, elapsed_time_seconds(&full_program_timer));
+        exit(EXIT_SUCCESS);
+    }
+
     fprintf(stderr, "Found");
 
     if (arguments.spanning)
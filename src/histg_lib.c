@@ -70,6 +70,45 @@ void graph_copy(const Graph *original, Graph *copy)
     memcpy(copy->adjacency_matrix, original->adjacency_matrix, copy->vertices * sizeof(uint64_t));
 }
 
+Graph *graph_without_vertex(const Graph *original, unsigned int vertex)
+{
+    Graph *graph = empty_graph(original->vertices - 1);
+
+    // Vertices before the removed one keep their bit, the ones after it move one bit up
+    uint64_t before_mask = ~(~0ULL >> vertex);
+    uint64_t after_mask = vertex < 63 ? ~0ULL >> (vertex + 1) : 0;
+
+    unsigned int row = 0;
+    for (unsigned int original_row = 0; original_row < original->vertices; original_row++)
+    {
+        if (original_row == vertex)
+            continue;
+
+        uint64_t adjacencies = original->adjacency_matrix[original_row];
+        graph->adjacency_matrix[row++] = (adjacencies & before_mask) | ((adjacencies & after_mask) << 1);
+    }
+
+    graph->edges = original->edges - vertex_degree(original->adjacency_matrix[vertex]);
+    return graph;
+}
+
+Graph *graph_map_vertices(const Graph *original, const unsigned int *map)
+{
+    Graph *graph = empty_graph(original->vertices);
+
+    for (unsigned int vertex = 0; vertex < original->vertices; vertex++)
+    {
+        uint64_t adjacencies = 0;
+        for (uint64_t rest = original->adjacency_matrix[vertex]; rest; rest &= ~(FIRST_BIT >> first_bit_position(rest)))
+            adjacencies |= FIRST_BIT >> map[first_bit_position(rest)];
+
+        graph->adjacency_matrix[map[vertex]] = adjacencies;
+    }
+
+    graph->edges = original->edges;
+    return graph;
+}
+
 void free_graph(Graph *graph)
 {
     free(graph->adjacency_matrix);
@@ -375,6 +414,17 @@ Graph parse_graph6_file(FILE *input)
 
 void print_graph_to_output(Output *output, Graph *graph)
 {
+    if (output->labels)
+    {
+        Graph *labeled = graph_map_vertices(graph, output->labels);
+        Output as_is = *output;
+        as_is.labels = NULL;
+
+        print_graph_to_output(&as_is, labeled);
+        free_graph(labeled);
+        return;
+    }
+
     switch (output->format)
     {
     case (AdjacencyMatrix):
@@ -3,6 +3,7 @@
 
 #include <histg_lib.h>
 #include <kirchhoff.h>
+#include <modular.h>
 
 /*
  * Integer Matrix
@@ -183,4 +184,446 @@ long long int kirchhoff(Graph *graph)
     free(laplacian.data);
     free(sublaplacian.data);
     return result;
-}
\ No newline at end of file
+}
+
+uint64_t determinant_mod_in_place(uint64_t *data, int n, uint64_t p)
+{
+    uint64_t result = 1;
+
+    for (int k = 0; k < n; k++)
+    {
+        uint64_t *row_k = data + k * n;
+
+        int pivot = k;
+        while (pivot < n && data[pivot * n + k] == 0)
+            pivot++;
+
+        if (pivot == n)
+            return 0;
+
+        // Swapping two rows flips the sign of the determinant
+        if (pivot != k)
+        {
+            uint64_t *row_pivot = data + pivot * n;
+            for (int j = k; j < n; j++)
+            {
+                uint64_t temp = row_k[j];
+                row_k[j] = row_pivot[j];
+                row_pivot[j] = temp;
+            }
+            result = mod_sub(0, result, p);
+        }
+
+        result = mod_mul(result, row_k[k], p);
+        uint64_t inverse = mod_inverse(row_k[k], p);
+
+        for (int i = k + 1; i < n; i++)
+        {
+            uint64_t *row_i = data + i * n;
+
+            if (row_i[k] == 0)
+                continue;
+
+            uint64_t factor = mod_mul(row_i[k], inverse, p);
+
+            for (int j = k + 1; j < n; j++)
+                row_i[j] = mod_sub(row_i[j], mod_mul(factor, row_k[j], p), p);
+        }
+    }
+
+    return result;
+}
+
+uint64_t determinant_mod(IMatrix *matrix, uint64_t p)
+{
+    if (matrix->rows != matrix->columns)
+    {
+        fprintf(stderr, "Attempting to calculate determinant for non-square matrix.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    int n = matrix->rows;
+    uint64_t *data = malloc((n * n + 1) * sizeof(uint64_t));
+
+    if (data == NULL)
+    {
+        fprintf(stderr, "Failed to allocate matrix for modular determinant.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int i = 0; i < n * n; i++)
+        data[i] = mod_from_signed(matrix->data[i], p);
+
+    uint64_t result = determinant_mod_in_place(data, n, p);
+
+    free(data);
+    return result;
+}
+
+uint64_t inverse_mod(IMatrix *matrix, uint64_t p, uint64_t *inverse)
+{
+    if (matrix->rows != matrix->columns)
+    {
+        fprintf(stderr, "Attempting to invert non-square matrix.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    int n = matrix->rows;
+    uint64_t *data = malloc((n * n + 1) * sizeof(uint64_t));
+
+    if (data == NULL)
+    {
+        fprintf(stderr, "Failed to allocate matrix for modular inverse.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int i = 0; i < n * n; i++)
+    {
+        data[i] = mod_from_signed(matrix->data[i], p);
+        inverse[i] = 0;
+    }
+
+    for (int i = 0; i < n; i++)
+        inverse[i * n + i] = 1;
+
+    uint64_t result = 1;
+
+    for (int k = 0; k < n; k++)
+    {
+        int pivot = k;
+        while (pivot < n && data[pivot * n + k] == 0)
+            pivot++;
+
+        if (pivot == n)
+        {
+            result = 0;
+            break;
+        }
+
+        if (pivot != k)
+        {
+            for (int j = 0; j < n; j++)
+            {
+                uint64_t temp = data[k * n + j];
+                data[k * n + j] = data[pivot * n + j];
+                data[pivot * n + j] = temp;
+
+                temp = inverse[k * n + j];
+                inverse[k * n + j] = inverse[pivot * n + j];
+                inverse[pivot * n + j] = temp;
+            }
+            result = mod_sub(0, result, p);
+        }
+
+        result = mod_mul(result, data[k * n + k], p);
+        uint64_t pivot_inverse = mod_inverse(data[k * n + k], p);
+
+        for (int j = 0; j < n; j++)
+        {
+            data[k * n + j] = mod_mul(data[k * n + j], pivot_inverse, p);
+            inverse[k * n + j] = mod_mul(inverse[k * n + j], pivot_inverse, p);
+        }
+
+        for (int i = 0; i < n; i++)
+        {
+            uint64_t factor = data[i * n + k];
+
+            if (i == k || factor == 0)
+                continue;
+
+            for (int j = 0; j < n; j++)
+            {
+                data[i * n + j] = mod_sub(data[i * n + j], mod_mul(factor, data[k * n + j], p), p);
+                inverse[i * n + j] = mod_sub(inverse[i * n + j], mod_mul(factor, inverse[k * n + j], p), p);
+            }
+        }
+    }
+
+    free(data);
+    return result;
+}
+
+uint64_t kirchhoff_mod(Graph *graph, uint64_t p)
+{
+    // The graph without vertices has no spanning tree
+    if (graph->vertices == 0)
+        return 0;
+
+    IMatrix laplacian = igraph_laplacian(graph);
+    IMatrix sublaplacian = icreate_submatrix(&laplacian, 0, 0);
+    uint64_t result = determinant_mod(&sublaplacian, p);
+    free(laplacian.data);
+    free(sublaplacian.data);
+    return result;
+}
+
+int spanning_tree_bits(Graph *graph)
+{
+    // Every spanning tree picks a distinct parent edge for each vertex except the root,
+    // so the product of those degrees bounds the number of spanning trees
+    int bits = 1;
+
+    for (int vertex = 1; vertex < graph->vertices; vertex++)
+    {
+        int degree = vertex_degree(graph->adjacency_matrix[vertex]);
+
+        while (degree)
+        {
+            bits++;
+            degree >>= 1;
+        }
+    }
+
+    return bits;
+}
+
+BigNat bignat_from_residues(uint64_t *residues, const uint64_t *primes, int nb_primes)
+{
+    // Garner's algorithm, the result is sum digits[i] * (p_0 * ... * p_i-1)
+    uint64_t digits[nb_primes];
+
+    for (int i = 0; i < nb_primes; i++)
+    {
+        uint64_t p = primes[i];
+
+        // Value of the previous digits and product of the previous primes modulo p
+        uint64_t value = 0;
+        uint64_t product = 1;
+
+        for (int j = 0; j < i; j++)
+        {
+            value = mod_add(value, mod_mul(digits[j] % p, product, p), p);
+            product = mod_mul(product, primes[j] % p, p);
+        }
+
+        digits[i] = mod_mul(mod_sub(residues[i] % p, value, p), mod_inverse(product, p), p);
+    }
+
+    BigNat result = bignat_from_u64(0);
+
+    for (int i = nb_primes - 1; i >= 0; i--)
+    {
+        bignat_mul_u64(&result, primes[i]);
+        bignat_add_u64(&result, digits[i]);
+    }
+
+    return result;
+}
+
+BigNat kirchhoff_exact(Graph *graph)
+{
+    // All primes are larger than 2^61
+    int nb_primes = spanning_tree_bits(graph) / 61 + 1;
+
+    if (nb_primes > NB_MODULAR_PRIMES)
+    {
+        fprintf(stderr, "Not enough primes to count spanning trees exactly.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    IMatrix laplacian = igraph_laplacian(graph);
+    IMatrix sublaplacian = icreate_submatrix(&laplacian, 0, 0);
+
+    uint64_t residues[NB_MODULAR_PRIMES];
+    for (int i = 0; i < nb_primes; i++)
+        residues[i] = determinant_mod(&sublaplacian, MODULAR_PRIMES[i]);
+
+    free(laplacian.data);
+    free(sublaplacian.data);
+    return bignat_from_residues(residues, MODULAR_PRIMES, nb_primes);
+}
+
+// Number of spanning trees of the graph without the given vertex modulo a prime
+uint64_t vertex_deletion_mod(Graph *graph, int vertex, uint64_t p)
+{
+    if (graph->vertices == 1)
+        return 0;
+
+    Graph *subgraph = graph_without_vertex(graph, vertex);
+    uint64_t result = kirchhoff_mod(subgraph, p);
+    free_graph(subgraph);
+    return result;
+}
+
+// Computes every deletion with its own determinant, used when the reduced Laplacian is singular modulo p
+void deletions_mod_direct(Graph *graph, Edge *edges, uint64_t p, uint64_t *edge_residues, uint64_t *vertex_residues)
+{
+    for (unsigned int e = 0; e < graph->edges; e++)
+    {
+        remove_edge_from_graph(graph, &edges[e]);
+        edge_residues[e] = kirchhoff_mod(graph, p);
+        add_edge_to_graph(graph, &edges[e]);
+    }
+
+    for (int v = 0; v < graph->vertices; v++)
+        vertex_residues[v] = vertex_deletion_mod(graph, v, p);
+}
+
+// Deletions modulo p from the inverse X of the reduced Laplacian L0, grounded at vertex 0.
+// Removing edge uv leaves tau * (1 - R_uv) trees, with effective resistance R_uv = X_uu + X_vv - 2 X_uv.
+// Removing vertex v leaves the minor of L0 without v, with the degrees of its neighbours lowered,
+// which the matrix determinant lemma gives as det(L0 - v) * det(I - (L0 - v)^-1 restricted to N(v)).
+// Every vertex still needs a deg(v) x deg(v) determinant, so the vertices cost O(sum deg(v)^3): below the
+// O(n^4) of direct determinants on sparse graphs, but the same order on dense ones.
+void deletions_mod_inverse(Graph *graph, Edge *edges, uint64_t p, uint64_t tau, uint64_t *inverse, uint64_t *edge_residues, uint64_t *vertex_residues)
+{
+    int size = graph->vertices - 1;
+
+    for (unsigned int e = 0; e < graph->edges; e++)
+    {
+        int u = edges[e].origin - 1;
+        int v = edges[e].destination - 1;
+
+        // Vertex 0 is grounded, its row and column of X are zero
+        uint64_t resistance = inverse[v * size + v];
+        if (u >= 0)
+        {
+            resistance = mod_add(resistance, inverse[u * size + u], p);
+            resistance = mod_sub(resistance, mod_add(inverse[u * size + v], inverse[u * size + v], p), p);
+        }
+
+        edge_residues[e] = mod_mul(tau, mod_sub(1, resistance, p), p);
+    }
+
+    vertex_residues[0] = vertex_deletion_mod(graph, 0, p);
+
+    int neighbours[64];
+    IMatrix correction;
+    correction.data = malloc(64 * 64 * sizeof(long long int));
+
+    for (int vertex = 1; vertex < graph->vertices; vertex++)
+    {
+        int v = vertex - 1;
+        uint64_t x_vv = inverse[v * size + v];
+
+        if (x_vv == 0)
+        {
+            vertex_residues[vertex] = vertex_deletion_mod(graph, vertex, p);
+            continue;
+        }
+
+        uint64_t x_vv_inverse = mod_inverse(x_vv, p);
+
+        int nb_neighbours = 0;
+        for (int w = 1; w < graph->vertices; w++)
+        {
+            if (graph->adjacency_matrix[vertex] & (FIRST_BIT >> w))
+                neighbours[nb_neighbours++] = w - 1;
+        }
+
+        correction.rows = nb_neighbours;
+        correction.columns = nb_neighbours;
+
+        for (int i = 0; i < nb_neighbours; i++)
+        {
+            int a = neighbours[i];
+            uint64_t x_av_scaled = mod_mul(inverse[a * size + v], x_vv_inverse, p);
+
+            for (int j = 0; j < nb_neighbours; j++)
+            {
+                int b = neighbours[j];
+                // Entry of (L0 - v)^-1, obtained from X by a Schur complement
+                uint64_t entry = mod_sub(inverse[a * size + b], mod_mul(x_av_scaled, inverse[v * size + b], p), p);
+                uint64_t value = mod_sub(i == j ? 1 : 0, entry, p);
+                iset_element(&correction, i, j, (long long int)value);
+            }
+        }
+
+        // det(L0 - v) is the cofactor tau * X_vv
+        uint64_t minor = mod_mul(tau, x_vv, p);
+        vertex_residues[vertex] = mod_mul(minor, determinant_mod(&correction, p), p);
+    }
+
+    free(correction.data);
+}
+
+void kirchhoff_deletions(Graph *graph, BigNat *edge_counts, BigNat *vertex_counts)
+{
+    int n = graph->vertices;
+    int m = graph->edges;
+
+    Edge *edges = malloc((m + 1) * sizeof(Edge));
+    int e = 0;
+    for (int origin = 0; origin < n; origin++)
+    {
+        for (int destination = origin + 1; destination < n; destination++)
+        {
+            if (graph->adjacency_matrix[origin] & (FIRST_BIT >> destination))
+            {
+                edges[e].origin = origin;
+                edges[e].destination = destination;
+                e++;
+            }
+        }
+    }
+
+    BigNat tau = kirchhoff_exact(graph);
+
+    // A disconnected graph stays disconnected without an edge,
+    // only removing a vertex can leave a connected graph
+    if (bignat_is_zero(&tau))
+    {
+        for (e = 0; e < m; e++)
+            edge_counts[e] = bignat_from_u64(0);
+
+        for (int v = 0; v < n; v++)
+        {
+            if (n == 1)
+            {
+                vertex_counts[v] = bignat_from_u64(0);
+                continue;
+            }
+
+            Graph *subgraph = graph_without_vertex(graph, v);
+            vertex_counts[v] = kirchhoff_exact(subgraph);
+            free_graph(subgraph);
+        }
+
+        free(edges);
+        return;
+    }
+
+    // Deleting an edge or a vertex of a connected graph never increases the bound
+    int nb_primes = spanning_tree_bits(graph) / 61 + 1;
+
+    uint64_t *edge_residues = malloc((m + 1) * nb_primes * sizeof(uint64_t));
+    uint64_t *vertex_residues = malloc(n * nb_primes * sizeof(uint64_t));
+    uint64_t *prime_edge_residues = malloc((m + 1) * sizeof(uint64_t));
+    uint64_t *prime_vertex_residues = malloc(n * sizeof(uint64_t));
+    uint64_t *inverse = malloc(n * n * sizeof(uint64_t));
+
+    IMatrix laplacian = igraph_laplacian(graph);
+    IMatrix sublaplacian = icreate_submatrix(&laplacian, 0, 0);
+
+    for (int i = 0; i < nb_primes; i++)
+    {
+        uint64_t p = MODULAR_PRIMES[i];
+        uint64_t tau_mod = inverse_mod(&sublaplacian, p, inverse);
+
+        if (tau_mod == 0)
+            deletions_mod_direct(graph, edges, p, prime_edge_residues, prime_vertex_residues);
+        else
+            deletions_mod_inverse(graph, edges, p, tau_mod, inverse, prime_edge_residues, prime_vertex_residues);
+
+        for (e = 0; e < m; e++)
+            edge_residues[e * nb_primes + i] = prime_edge_residues[e];
+
+        for (int v = 0; v < n; v++)
+            vertex_residues[v * nb_primes + i] = prime_vertex_residues[v];
+    }
+
+    for (e = 0; e < m; e++)
+        edge_counts[e] = bignat_from_residues(edge_residues + e * nb_primes, MODULAR_PRIMES, nb_primes);
+
+    for (int v = 0; v < n; v++)
+        vertex_counts[v] = bignat_from_residues(vertex_residues + v * nb_primes, MODULAR_PRIMES, nb_primes);
+
+    free(laplacian.data);
+    free(sublaplacian.data);
+    free(edge_residues);
+    free(vertex_residues);
+    free(prime_edge_residues);
+    free(prime_vertex_residues);
+    free(inverse);
+    free(edges);
+}
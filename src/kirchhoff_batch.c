@@ -0,0 +1,350 @@
+#include <stdlib.h>
+#include <immintrin.h>
+
+#include <histg_lib.h>
+#include <kirchhoff.h>
+#include <kirchhoff_batch.h>
+#include <modular.h>
+
+#define LANES KIRCHHOFF_BATCH_SIZE
+
+/*
+ * Montgomery arithmetic modulo a prime below 2^31 with R = 2^32.
+ * Residues are kept in [0, p) in the low half of a 64 bit lane.
+ */
+typedef struct Montgomery
+{
+    uint64_t p;
+    // -p^-1 mod 2^32
+    uint64_t p_negated_inverse;
+    // 2^32 mod p
+    uint64_t r;
+} Montgomery;
+
+Montgomery montgomery_new(uint64_t p)
+{
+    Montgomery montgomery;
+    montgomery.p = p;
+
+    // Newton iteration, every step doubles the number of correct low bits
+    uint32_t inverse = (uint32_t)p;
+    for (int i = 0; i < 5; i++)
+        inverse *= 2 - (uint32_t)p * inverse;
+
+    montgomery.p_negated_inverse = (uint32_t)-inverse;
+    montgomery.r = (1ULL << 32) % p;
+    return montgomery;
+}
+
+uint64_t montgomery_mul(Montgomery *montgomery, uint64_t a, uint64_t b)
+{
+    uint64_t t = a * b;
+    uint64_t m = (uint32_t)t * montgomery->p_negated_inverse;
+    uint64_t u = (t + (uint32_t)m * montgomery->p) >> 32;
+    return u >= montgomery->p ? u - montgomery->p : u;
+}
+
+uint64_t montgomery_sub(Montgomery *montgomery, uint64_t a, uint64_t b)
+{
+    return a >= b ? a - b : a + montgomery->p - b;
+}
+
+/*
+ * Division free elimination of all lanes at once.
+ * Row i is replaced by pivot * row i - a_ik * row k, so the final diagonal d satisfies
+ * prod d_k = det * prod d_k^(size - 1 - k), see lb_determinants.
+ */
+void lb_eliminate_scalar(LaplacianBatch *batch, Montgomery *montgomery)
+{
+    int size = batch->size;
+    uint64_t *data = batch->data;
+
+    for (int k = 0; k < size; k++)
+    {
+        uint64_t *pivot = data + (k * size + k) * LANES;
+
+        for (int i = k + 1; i < size; i++)
+        {
+            uint64_t *a_ik = data + (i * size + k) * LANES;
+
+            for (int j = k + 1; j < size; j++)
+            {
+                uint64_t *a_ij = data + (i * size + j) * LANES;
+                uint64_t *a_kj = data + (k * size + j) * LANES;
+
+                for (int lane = 0; lane < LANES; lane++)
+                {
+                    uint64_t kept = montgomery_mul(montgomery, a_ij[lane], pivot[lane]);
+                    uint64_t removed = montgomery_mul(montgomery, a_ik[lane], a_kj[lane]);
+                    a_ij[lane] = montgomery_sub(montgomery, kept, removed);
+                }
+            }
+        }
+    }
+}
+
+__attribute__((target("avx2"))) static inline __m256i montgomery_mul_avx2(__m256i a, __m256i b, __m256i p, __m256i p_negated_inverse)
+{
+    __m256i t = _mm256_mul_epu32(a, b);
+    __m256i m = _mm256_mul_epu32(t, p_negated_inverse);
+    __m256i u = _mm256_srli_epi64(_mm256_add_epi64(t, _mm256_mul_epu32(m, p)), 32);
+    // u < 2p < 2^32, if u < p then u - p wraps to a larger value in both 32 bit halves
+    return _mm256_min_epu32(u, _mm256_sub_epi64(u, p));
+}
+
+__attribute__((target("avx2"))) void lb_eliminate_avx2(LaplacianBatch *batch, Montgomery *montgomery)
+{
+    int size = batch->size;
+    uint64_t *data = batch->data;
+
+    __m256i p = _mm256_set1_epi64x(montgomery->p);
+    __m256i p_negated_inverse = _mm256_set1_epi64x(montgomery->p_negated_inverse);
+
+    for (int k = 0; k < size; k++)
+    {
+        for (int half = 0; half < LANES; half += 4)
+        {
+            __m256i pivot = _mm256_loadu_si256((__m256i *)(data + (k * size + k) * LANES + half));
+
+            for (int i = k + 1; i < size; i++)
+            {
+                __m256i a_ik = _mm256_loadu_si256((__m256i *)(data + (i * size + k) * LANES + half));
+
+                for (int j = k + 1; j < size; j++)
+                {
+                    __m256i *a_ij_address = (__m256i *)(data + (i * size + j) * LANES + half);
+                    __m256i a_kj = _mm256_loadu_si256((__m256i *)(data + (k * size + j) * LANES + half));
+                    __m256i a_ij = _mm256_loadu_si256(a_ij_address);
+
+                    __m256i kept = montgomery_mul_avx2(a_ij, pivot, p, p_negated_inverse);
+                    __m256i removed = montgomery_mul_avx2(a_ik, a_kj, p, p_negated_inverse);
+                    __m256i difference = _mm256_add_epi64(_mm256_sub_epi64(kept, removed), p);
+
+                    _mm256_storeu_si256(a_ij_address, _mm256_min_epu32(difference, _mm256_sub_epi64(difference, p)));
+                }
+            }
+        }
+    }
+}
+
+__attribute__((target("avx512f"))) static inline __m512i montgomery_mul_avx512(__m512i a, __m512i b, __m512i p, __m512i p_negated_inverse)
+{
+    __m512i t = _mm512_mul_epu32(a, b);
+    __m512i m = _mm512_mul_epu32(t, p_negated_inverse);
+    __m512i u = _mm512_srli_epi64(_mm512_add_epi64(t, _mm512_mul_epu32(m, p)), 32);
+    return _mm512_min_epu32(u, _mm512_sub_epi64(u, p));
+}
+
+__attribute__((target("avx512f"))) void lb_eliminate_avx512(LaplacianBatch *batch, Montgomery *montgomery)
+{
+    int size = batch->size;
+    uint64_t *data = batch->data;
+
+    __m512i p = _mm512_set1_epi64(montgomery->p);
+    __m512i p_negated_inverse = _mm512_set1_epi64(montgomery->p_negated_inverse);
+
+    for (int k = 0; k < size; k++)
+    {
+        __m512i pivot = _mm512_loadu_si512(data + (k * size + k) * LANES);
+
+        for (int i = k + 1; i < size; i++)
+        {
+            __m512i a_ik = _mm512_loadu_si512(data + (i * size + k) * LANES);
+
+            for (int j = k + 1; j < size; j++)
+            {
+                uint64_t *a_ij_address = data + (i * size + j) * LANES;
+                __m512i a_kj = _mm512_loadu_si512(data + (k * size + j) * LANES);
+                __m512i a_ij = _mm512_loadu_si512(a_ij_address);
+
+                __m512i kept = montgomery_mul_avx512(a_ij, pivot, p, p_negated_inverse);
+                __m512i removed = montgomery_mul_avx512(a_ik, a_kj, p, p_negated_inverse);
+                __m512i difference = _mm512_add_epi64(_mm512_sub_epi64(kept, removed), p);
+
+                _mm512_storeu_si512(a_ij_address, _mm512_min_epu32(difference, _mm512_sub_epi64(difference, p)));
+            }
+        }
+    }
+}
+
+LaplacianBatch *lb_new(int max_vertices)
+{
+    LaplacianBatch *batch = malloc(sizeof(LaplacianBatch));
+
+    if (batch == NULL)
+    {
+        fprintf(stderr, "Failed to allocate Laplacian batch.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    int size = max_vertices > 1 ? max_vertices - 1 : 1;
+    batch->data = malloc(size * size * LANES * sizeof(uint64_t));
+    batch->size = 0;
+    batch->max_size = size;
+    batch->nb_graphs = 0;
+
+    if (batch->data == NULL)
+    {
+        fprintf(stderr, "Failed to allocate Laplacian batch.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    return batch;
+}
+
+void free_lb(LaplacianBatch *batch)
+{
+    free(batch->data);
+    free(batch);
+}
+
+// Loads the reduced Laplacians as residues modulo p, vertex 0 is removed.
+// Lanes without a graph get an identity matrix.
+void lb_load(LaplacianBatch *batch, uint64_t p, Graph **graphs, int nb_graphs)
+{
+    int size = batch->size;
+
+    for (int lane = 0; lane < LANES; lane++)
+    {
+        for (int row = 0; row < size; row++)
+        {
+            uint64_t adjacencies = lane < nb_graphs ? graphs[lane]->adjacency_matrix[row + 1] : 0;
+
+            for (int column = 0; column < size; column++)
+            {
+                uint64_t value = 0;
+
+                if (row == column)
+                    value = lane < nb_graphs ? vertex_degree(adjacencies) : 1;
+                else if (adjacencies & (FIRST_BIT >> (column + 1)))
+                    value = p - 1;
+
+                batch->data[(row * size + column) * LANES + lane] = value;
+            }
+        }
+    }
+}
+
+void lb_determinants_mod(LaplacianBatch *batch, uint64_t p, uint64_t *numerators, uint64_t *denominators, bool *zero_pivots)
+{
+    int size = batch->size;
+    Montgomery montgomery = montgomery_new(p);
+
+    if (__builtin_cpu_supports("avx512f"))
+        lb_eliminate_avx512(batch, &montgomery);
+    else if (__builtin_cpu_supports("avx2"))
+        lb_eliminate_avx2(batch, &montgomery);
+    else
+        lb_eliminate_scalar(batch, &montgomery);
+
+    // Every step squares the scaling of the remaining entries and adds a factor R^-1,
+    // so the pivot of step k carries R^-(2^k - 1). Montgomery multiplication by R^(2^k + 1)
+    // turns it into the Montgomery form of the pivot, the same for every lane.
+    uint64_t corrections[64];
+    uint64_t correction = montgomery.r;
+    for (int k = 0; k < size; k++)
+    {
+        corrections[k] = correction * montgomery.r % p;
+        correction = correction * correction % p;
+    }
+
+    for (int lane = 0; lane < batch->nb_graphs; lane++)
+    {
+        // The determinant is the product of the pivots divided by prod_k pivot_k^(size - 1 - k),
+        // which is the product of the prefix products of the pivots except the last one.
+        // Both are kept in Montgomery form, which leaves their ratio unchanged.
+        uint64_t pivot_product = montgomery.r;
+        uint64_t scaling = montgomery.r;
+        zero_pivots[lane] = false;
+
+        for (int k = 0; k < size; k++)
+        {
+            uint64_t pivot = montgomery_mul(&montgomery, batch->data[(k * size + k) * LANES + lane], corrections[k]);
+
+            // A zero pivot before the last row wipes out the rows below it
+            if (pivot == 0 && k < size - 1)
+            {
+                zero_pivots[lane] = true;
+                break;
+            }
+
+            if (k > 0)
+                scaling = montgomery_mul(&montgomery, scaling, pivot_product);
+            pivot_product = montgomery_mul(&montgomery, pivot_product, pivot);
+        }
+
+        numerators[lane] = zero_pivots[lane] ? 0 : pivot_product;
+        denominators[lane] = scaling;
+    }
+}
+
+void kirchhoff_exact_batch(LaplacianBatch *batch, Graph **graphs, int nb_graphs, BigNat *results)
+{
+    if (nb_graphs < 1 || nb_graphs > LANES)
+    {
+        fprintf(stderr, "Invalid number of graphs in Laplacian batch.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if ((int)graphs[0]->vertices - 1 > batch->max_size)
+    {
+        fprintf(stderr, "Graphs are too large for the Laplacian batch.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    batch->size = graphs[0]->vertices - 1;
+    batch->nb_graphs = nb_graphs;
+
+    // All primes are larger than 2^30
+    int nb_primes = 0;
+    for (int lane = 0; lane < nb_graphs; lane++)
+    {
+        if (graphs[lane]->vertices != graphs[0]->vertices)
+        {
+            fprintf(stderr, "Graphs in a Laplacian batch must have the same number of vertices.\n");
+            exit(EXIT_FAILURE);
+        }
+
+        int lane_primes = spanning_tree_bits(graphs[lane]) / 30 + 1;
+        if (lane_primes > nb_primes)
+            nb_primes = lane_primes;
+    }
+
+    if (nb_primes > NB_MODULAR_PRIMES_31)
+    {
+        fprintf(stderr, "Not enough primes to count spanning trees exactly.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    if (batch->size == 0)
+    {
+        for (int lane = 0; lane < nb_graphs; lane++)
+            results[lane] = bignat_from_u64(1);
+        return;
+    }
+
+    uint64_t residues[LANES][NB_MODULAR_PRIMES_31];
+
+    for (int i = 0; i < nb_primes; i++)
+    {
+        uint64_t p = MODULAR_PRIMES_31[i];
+        lb_load(batch, p, graphs, nb_graphs);
+
+        uint64_t numerators[LANES];
+        uint64_t denominators[LANES];
+        bool zero_pivots[LANES];
+        lb_determinants_mod(batch, p, numerators, denominators, zero_pivots);
+
+        for (int lane = 0; lane < nb_graphs; lane++)
+        {
+            // Rare, fall back to elimination with pivoting for this graph
+            if (zero_pivots[lane])
+                residues[lane][i] = kirchhoff_mod(graphs[lane], p);
+            else
+                residues[lane][i] = numerators[lane] * mod_inverse(denominators[lane], p) % p;
+        }
+    }
+
+    for (int lane = 0; lane < nb_graphs; lane++)
+        results[lane] = bignat_from_residues(residues[lane], MODULAR_PRIMES_31, nb_primes);
+}
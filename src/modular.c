@@ -0,0 +1,95 @@
+#include <modular.h>
+
+const uint64_t MODULAR_PRIMES[NB_MODULAR_PRIMES] = {
+    0x3fffffffffffffc7ULL,
+    0x3fffffffffffffa9ULL,
+    0x3fffffffffffff8bULL,
+    0x3fffffffffffff71ULL,
+    0x3fffffffffffff67ULL,
+    0x3fffffffffffff59ULL,
+    0x3fffffffffffff55ULL,
+    0x3fffffffffffff3dULL,
+};
+
+const uint64_t MODULAR_PRIMES_31[NB_MODULAR_PRIMES_31] = {
+    0x7fffffffULL,
+    0x7fffffedULL,
+    0x7fffffc3ULL,
+    0x7fffffbbULL,
+    0x7fffffabULL,
+    0x7fffff9dULL,
+    0x7fffff97ULL,
+    0x7fffff69ULL,
+    0x7fffff61ULL,
+    0x7fffff55ULL,
+    0x7fffff1fULL,
+    0x7fffff07ULL,
+    0x7ffffed9ULL,
+    0x7ffffebbULL,
+    0x7ffffe85ULL,
+    0x7ffffe71ULL,
+};
+
+uint64_t mod_add(uint64_t a, uint64_t b, uint64_t p)
+{
+    uint64_t sum = a + b;
+    return sum >= p ? sum - p : sum;
+}
+
+uint64_t mod_sub(uint64_t a, uint64_t b, uint64_t p)
+{
+    return a >= b ? a - b : a + p - b;
+}
+
+uint64_t mod_mul(uint64_t a, uint64_t b, uint64_t p)
+{
+    return (uint64_t)(((unsigned __int128)a * b) % p);
+}
+
+uint64_t mod_pow(uint64_t base, uint64_t exponent, uint64_t p)
+{
+    uint64_t result = 1;
+    base %= p;
+
+    while (exponent)
+    {
+        if (exponent & 1)
+            result = mod_mul(result, base, p);
+
+        base = mod_mul(base, base, p);
+        exponent >>= 1;
+    }
+
+    return result;
+}
+
+uint64_t mod_inverse(uint64_t a, uint64_t p)
+{
+    // Extended Euclid, the coefficients stay below p in absolute value
+    int64_t t = 0, new_t = 1;
+    int64_t r = p, new_r = a % p;
+
+    while (new_r)
+    {
+        int64_t quotient = r / new_r;
+
+        int64_t temp = t - quotient * new_t;
+        t = new_t;
+        new_t = temp;
+
+        temp = r - quotient * new_r;
+        r = new_r;
+        new_r = temp;
+    }
+
+    return t < 0 ? (uint64_t)(t + (int64_t)p) : (uint64_t)t;
+}
+
+uint64_t mod_from_signed(long long int value, uint64_t p)
+{
+    if (value >= 0)
+        return (uint64_t)value % p;
+
+    uint64_t residue = (uint64_t)(-(value + 1)) % p;
+    return mod_sub(p - 1, residue, p);
+}
@@ -0,0 +1,141 @@
+#include <string.h>
+
+#include <relabel.h>
+
+bool relabeling_from_name(const char *name, Relabeling *relabeling)
+{
+    if (strcmp(name, "none") == 0)
+        *relabeling = RelabelNone;
+    else if (strcmp(name, "degeneracy") == 0)
+        *relabeling = RelabelDegeneracy;
+    else if (strcmp(name, "bfs") == 0)
+        *relabeling = RelabelBfs;
+    else if (strcmp(name, "cuthill-mckee") == 0)
+        *relabeling = RelabelCuthillMcKee;
+    else
+        return false;
+
+    return true;
+}
+
+// Vertex of candidates with the highest (or lowest) number of neighbours in counted, ties go to the lowest label
+unsigned int relabel_extreme_vertex(const Graph *graph, uint64_t candidates, uint64_t counted, bool highest)
+{
+    unsigned int best = first_bit_position(candidates);
+    unsigned int best_degree = vertex_degree(graph->adjacency_matrix[best] & counted);
+
+    for (uint64_t rest = candidates & ~(FIRST_BIT >> best); rest; rest &= ~(FIRST_BIT >> first_bit_position(rest)))
+    {
+        unsigned int vertex = first_bit_position(rest);
+        unsigned int degree = vertex_degree(graph->adjacency_matrix[vertex] & counted);
+
+        if (highest ? degree > best_degree : degree < best_degree)
+        {
+            best = vertex;
+            best_degree = degree;
+        }
+    }
+
+    return best;
+}
+
+void relabel_degeneracy(const Graph *graph, unsigned int *labels)
+{
+    unsigned int n = graph->vertices;
+    uint64_t remaining = n == 0 ? 0 : ~0ULL << (64 - n);
+
+    // Removed vertices take the last free label, so the last one removed comes first
+    for (unsigned int label = n; label > 0; label--)
+    {
+        unsigned int vertex = relabel_extreme_vertex(graph, remaining, remaining, false);
+        labels[label - 1] = vertex;
+        remaining &= ~(FIRST_BIT >> vertex);
+    }
+}
+
+void relabel_bfs(const Graph *graph, unsigned int *labels)
+{
+    unsigned int n = graph->vertices;
+    uint64_t all = n == 0 ? 0 : ~0ULL << (64 - n);
+    uint64_t labeled = 0;
+    uint64_t frontier = 0;
+
+    for (unsigned int label = 0; label < n; label++)
+    {
+        // A new component starts at its highest degree vertex
+        uint64_t candidates = frontier ? frontier : all & ~labeled;
+        unsigned int vertex = relabel_extreme_vertex(graph, candidates, all, true);
+
+        labels[label] = vertex;
+        labeled |= FIRST_BIT >> vertex;
+        frontier = (frontier | graph->adjacency_matrix[vertex]) & ~labeled;
+    }
+}
+
+void relabel_cuthill_mckee(const Graph *graph, unsigned int *labels)
+{
+    unsigned int n = graph->vertices;
+    uint64_t all = n == 0 ? 0 : ~0ULL << (64 - n);
+    uint64_t labeled = 0;
+    unsigned int end = 0;
+
+    // labels doubles as the queue, head is the vertex whose neighbours are labeled next
+    for (unsigned int head = 0; end < n; head++)
+    {
+        if (head == end)
+        {
+            // Queue ran out, a new component starts at its lowest degree vertex
+            unsigned int start = relabel_extreme_vertex(graph, all & ~labeled, all, false);
+            labels[end++] = start;
+            labeled |= FIRST_BIT >> start;
+        }
+
+        uint64_t neighbours = graph->adjacency_matrix[labels[head]] & ~labeled;
+
+        while (neighbours)
+        {
+            unsigned int neighbour = relabel_extreme_vertex(graph, neighbours, all, false);
+            labels[end++] = neighbour;
+            labeled |= FIRST_BIT >> neighbour;
+            neighbours &= ~(FIRST_BIT >> neighbour);
+        }
+    }
+}
+
+void relabel_order(const Graph *graph, Relabeling relabeling, unsigned int *labels)
+{
+    switch (relabeling)
+    {
+    case (RelabelNone):
+    {
+        for (unsigned int vertex = 0; vertex < graph->vertices; vertex++)
+            labels[vertex] = vertex;
+        break;
+    }
+    case (RelabelDegeneracy):
+    {
+        relabel_degeneracy(graph, labels);
+        break;
+    }
+    case (RelabelBfs):
+    {
+        relabel_bfs(graph, labels);
+        break;
+    }
+    case (RelabelCuthillMcKee):
+    {
+        relabel_cuthill_mckee(graph, labels);
+        break;
+    }
+    }
+}
+
+Graph *relabel_graph(const Graph *graph, const unsigned int *labels)
+{
+    unsigned int positions[64];
+
+    for (unsigned int label = 0; label < graph->vertices; label++)
+        positions[labels[label]] = label;
+
+    return graph_map_vertices(graph, positions);
+}
@@ -684,7 +684,9 @@ bool find_hists_hd(Graph *input_graph, uint64_t hidden_vertices, Output *output,
 
     HideData hide_data = construct_hide_data(hidden_vertices, input_graph->vertices);
 
+    rd_start_run(run_data);
     hists_hd(graph, tree, &hide_data, output, find_one, run_data);
+    rd_finish_run(run_data);
 
     free_graph(graph);
     free_graph(tree);
@@ -0,0 +1,407 @@
+#include <stdlib.h>
+#include <math.h>
+
+#include <sparse_laplacian.h>
+#include <modular.h>
+
+bool parse_edge_list(FILE *input, EdgeList *edge_list)
+{
+    if (fscanf(input, "%d %d", &edge_list->vertices, &edge_list->edges) != 2)
+        return false;
+
+    if (edge_list->vertices < 1 || edge_list->edges < 0)
+    {
+        fprintf(stderr, "Invalid edge list header.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    edge_list->origins = malloc((edge_list->edges + 1) * sizeof(int));
+    edge_list->destinations = malloc((edge_list->edges + 1) * sizeof(int));
+
+    if (edge_list->origins == NULL || edge_list->destinations == NULL)
+    {
+        fprintf(stderr, "Failed to allocate edge list.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int e = 0; e < edge_list->edges; e++)
+    {
+        int origin, destination;
+
+        if (fscanf(input, "%d %d", &origin, &destination) != 2 || origin < 0 || destination < 0 || origin >= edge_list->vertices || destination >= edge_list->vertices)
+        {
+            fprintf(stderr, "Invalid edge in edge list.\n");
+            exit(EXIT_FAILURE);
+        }
+
+        edge_list->origins[e] = origin;
+        edge_list->destinations[e] = destination;
+    }
+
+    return true;
+}
+
+void free_edge_list(EdgeList *edge_list)
+{
+    free(edge_list->origins);
+    free(edge_list->destinations);
+}
+
+int uf_find(int *parents, int vertex)
+{
+    while (parents[vertex] != vertex)
+    {
+        parents[vertex] = parents[parents[vertex]];
+        vertex = parents[vertex];
+    }
+
+    return vertex;
+}
+
+bool edge_list_is_connected(EdgeList *edge_list)
+{
+    int *parents = malloc(edge_list->vertices * sizeof(int));
+    for (int v = 0; v < edge_list->vertices; v++)
+        parents[v] = v;
+
+    int components = edge_list->vertices;
+
+    for (int e = 0; e < edge_list->edges; e++)
+    {
+        int a = uf_find(parents, edge_list->origins[e]);
+        int b = uf_find(parents, edge_list->destinations[e]);
+
+        if (a != b)
+        {
+            parents[a] = b;
+            components--;
+        }
+    }
+
+    free(parents);
+    return components == 1;
+}
+
+void sr_append(SparseRow *row, int column, double value, uint64_t residue)
+{
+    if (row->size == row->capacity)
+    {
+        row->capacity = row->capacity ? 2 * row->capacity : 4;
+        row->entries = realloc(row->entries, row->capacity * sizeof(SparseEntry));
+
+        if (row->entries == NULL)
+        {
+            fprintf(stderr, "Failed to grow sparse row.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    SparseEntry *entry = &row->entries[row->size++];
+    entry->column = column;
+    entry->value = value;
+    entry->residue = residue;
+}
+
+SparseLaplacian *sparse_laplacian(EdgeList *edge_list, uint64_t p)
+{
+    int n = edge_list->vertices;
+
+    SparseLaplacian *laplacian = malloc(sizeof(SparseLaplacian));
+    laplacian->vertices = n;
+    laplacian->p = p;
+    laplacian->rows = calloc(n, sizeof(SparseRow));
+    laplacian->diagonal = calloc(n, sizeof(double));
+    laplacian->diagonal_residues = calloc(n, sizeof(uint64_t));
+
+    // Edges grouped by endpoint, so parallel edges can be merged row by row
+    int *offsets = calloc(n + 1, sizeof(int));
+    int *neighbours = malloc((2 * edge_list->edges + 1) * sizeof(int));
+
+    if (laplacian->rows == NULL || laplacian->diagonal == NULL || laplacian->diagonal_residues == NULL || offsets == NULL || neighbours == NULL)
+    {
+        fprintf(stderr, "Failed to allocate sparse Laplacian.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int e = 0; e < edge_list->edges; e++)
+    {
+        if (edge_list->origins[e] == edge_list->destinations[e])
+            continue;
+
+        offsets[edge_list->origins[e] + 1]++;
+        offsets[edge_list->destinations[e] + 1]++;
+    }
+
+    for (int v = 0; v < n; v++)
+        offsets[v + 1] += offsets[v];
+
+    int *fill = malloc(n * sizeof(int));
+    for (int v = 0; v < n; v++)
+        fill[v] = offsets[v];
+
+    for (int e = 0; e < edge_list->edges; e++)
+    {
+        int origin = edge_list->origins[e];
+        int destination = edge_list->destinations[e];
+
+        if (origin == destination)
+            continue;
+
+        neighbours[fill[origin]++] = destination;
+        neighbours[fill[destination]++] = origin;
+    }
+
+    // Ground the vertex with the highest degree, it would produce the most fill
+    laplacian->ground = 0;
+    for (int v = 1; v < n; v++)
+    {
+        if (offsets[v + 1] - offsets[v] > offsets[laplacian->ground + 1] - offsets[laplacian->ground])
+            laplacian->ground = v;
+    }
+
+    // Position of each column in the row being built, -1 if absent
+    int *positions = fill;
+    for (int v = 0; v < n; v++)
+        positions[v] = -1;
+
+    for (int v = 0; v < n; v++)
+    {
+        int degree = offsets[v + 1] - offsets[v];
+        laplacian->diagonal[v] = degree;
+        laplacian->diagonal_residues[v] = degree % p;
+
+        if (v == laplacian->ground)
+            continue;
+
+        SparseRow *row = &laplacian->rows[v];
+
+        for (int i = offsets[v]; i < offsets[v + 1]; i++)
+        {
+            int w = neighbours[i];
+
+            if (w == laplacian->ground)
+                continue;
+
+            if (positions[w] < 0)
+            {
+                positions[w] = row->size;
+                sr_append(row, w, -1, p - 1);
+            }
+            else
+            {
+                SparseEntry *entry = &row->entries[positions[w]];
+                entry->value -= 1;
+                entry->residue = mod_sub(entry->residue, 1, p);
+            }
+        }
+
+        for (int i = 0; i < row->size; i++)
+            positions[row->entries[i].column] = -1;
+    }
+
+    free(offsets);
+    free(neighbours);
+    free(fill);
+    return laplacian;
+}
+
+void free_sparse_laplacian(SparseLaplacian *laplacian)
+{
+    for (int v = 0; v < laplacian->vertices; v++)
+        free(laplacian->rows[v].entries);
+
+    free(laplacian->rows);
+    free(laplacian->diagonal);
+    free(laplacian->diagonal_residues);
+    free(laplacian);
+}
+
+void dh_push(DegreeHeap *heap, int degree, int vertex)
+{
+    if (heap->size == heap->capacity)
+    {
+        heap->capacity = heap->capacity ? 2 * heap->capacity : 64;
+        heap->degrees = realloc(heap->degrees, heap->capacity * sizeof(int));
+        heap->vertices = realloc(heap->vertices, heap->capacity * sizeof(int));
+
+        if (heap->degrees == NULL || heap->vertices == NULL)
+        {
+            fprintf(stderr, "Failed to grow degree heap.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    int i = heap->size++;
+    while (i > 0 && heap->degrees[(i - 1) / 2] > degree)
+    {
+        heap->degrees[i] = heap->degrees[(i - 1) / 2];
+        heap->vertices[i] = heap->vertices[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+
+    heap->degrees[i] = degree;
+    heap->vertices[i] = vertex;
+}
+
+void dh_pop(DegreeHeap *heap, int *degree, int *vertex)
+{
+    *degree = heap->degrees[0];
+    *vertex = heap->vertices[0];
+
+    int last_degree = heap->degrees[--heap->size];
+    int last_vertex = heap->vertices[heap->size];
+
+    int i = 0;
+    while (2 * i + 1 < heap->size)
+    {
+        int child = 2 * i + 1;
+        if (child + 1 < heap->size && heap->degrees[child + 1] < heap->degrees[child])
+            child++;
+
+        if (heap->degrees[child] >= last_degree)
+            break;
+
+        heap->degrees[i] = heap->degrees[child];
+        heap->vertices[i] = heap->vertices[child];
+        i = child;
+    }
+
+    heap->degrees[i] = last_degree;
+    heap->vertices[i] = last_vertex;
+}
+
+SparseTreeCount sparse_ldlt(SparseLaplacian *laplacian)
+{
+    int n = laplacian->vertices;
+    uint64_t p = laplacian->p;
+
+    SparseTreeCount count;
+    count.log_tau = 0;
+    count.tau_mod = 1;
+    count.tau_mod_known = true;
+
+    bool *eliminated = calloc(n, sizeof(bool));
+    int *positions = malloc(n * sizeof(int));
+    DegreeHeap heap = {NULL, NULL, 0, 0};
+
+    for (int v = 0; v < n; v++)
+    {
+        positions[v] = -1;
+
+        if (v != laplacian->ground)
+            dh_push(&heap, laplacian->rows[v].size, v);
+    }
+
+    int remaining = n - 1;
+
+    while (remaining > 0)
+    {
+        int degree, k;
+        dh_pop(&heap, &degree, &k);
+
+        if (eliminated[k] || degree != laplacian->rows[k].size)
+            continue;
+
+        eliminated[k] = true;
+        remaining--;
+
+        double pivot = laplacian->diagonal[k];
+        uint64_t pivot_residue = laplacian->diagonal_residues[k];
+
+        count.log_tau += log(pivot);
+        count.tau_mod = mod_mul(count.tau_mod, pivot_residue, p);
+
+        SparseRow *row_k = &laplacian->rows[k];
+
+        if (row_k->size == 0)
+            continue;
+
+        // Only the last pivot may vanish without breaking the modular elimination,
+        // the floating point values don't depend on the residues and are still eliminated
+        if (pivot_residue == 0)
+            count.tau_mod_known = false;
+
+        uint64_t pivot_inverse = count.tau_mod_known ? mod_inverse(pivot_residue, p) : 0;
+
+        // Schur complement: L_ij -= L_ik L_kj / L_kk for all neighbours i, j of k
+        for (int a = 0; a < row_k->size; a++)
+        {
+            SparseEntry entry_ik = row_k->entries[a];
+            SparseRow *row_i = &laplacian->rows[entry_ik.column];
+
+            for (int b = 0; b < row_i->size; b++)
+                positions[row_i->entries[b].column] = b;
+
+            // Remove k from row i
+            int k_position = positions[k];
+            positions[row_i->entries[row_i->size - 1].column] = k_position;
+            row_i->entries[k_position] = row_i->entries[--row_i->size];
+            positions[k] = -1;
+
+            double factor = entry_ik.value / pivot;
+            uint64_t factor_residue = mod_mul(entry_ik.residue, pivot_inverse, p);
+
+            laplacian->diagonal[entry_ik.column] -= factor * entry_ik.value;
+            laplacian->diagonal_residues[entry_ik.column] = mod_sub(laplacian->diagonal_residues[entry_ik.column], mod_mul(factor_residue, entry_ik.residue, p), p);
+
+            for (int c = 0; c < row_k->size; c++)
+            {
+                if (c == a)
+                    continue;
+
+                SparseEntry entry_kj = row_k->entries[c];
+                double value = factor * entry_kj.value;
+                uint64_t residue = mod_mul(factor_residue, entry_kj.residue, p);
+
+                if (positions[entry_kj.column] >= 0)
+                {
+                    SparseEntry *entry_ij = &row_i->entries[positions[entry_kj.column]];
+                    entry_ij->value -= value;
+                    entry_ij->residue = mod_sub(entry_ij->residue, residue, p);
+                }
+                else
+                {
+                    // Fill in
+                    sr_append(row_i, entry_kj.column, -value, mod_sub(0, residue, p));
+                }
+            }
+
+            for (int b = 0; b < row_i->size; b++)
+                positions[row_i->entries[b].column] = -1;
+
+            dh_push(&heap, row_i->size, entry_ik.column);
+        }
+
+        free(row_k->entries);
+        row_k->entries = NULL;
+        row_k->size = 0;
+        row_k->capacity = 0;
+    }
+
+    free(eliminated);
+    free(positions);
+    free(heap.degrees);
+    free(heap.vertices);
+
+    if (!count.tau_mod_known)
+        count.tau_mod = 0;
+
+    return count;
+}
+
+SparseTreeCount sparse_kirchhoff(EdgeList *edge_list, uint64_t p)
+{
+    if (!edge_list_is_connected(edge_list))
+    {
+        SparseTreeCount count;
+        count.log_tau = -INFINITY;
+        count.tau_mod = 0;
+        count.tau_mod_known = true;
+        return count;
+    }
+
+    SparseLaplacian *laplacian = sparse_laplacian(edge_list, p);
+    SparseTreeCount count = sparse_ldlt(laplacian);
+    free_sparse_laplacian(laplacian);
+    return count;
+}
@@ -40,12 +40,13 @@ WEdge edge_new(int label_a, int label_b)
     return edge;
 }
 
-typedef struct EdgeSetNode EdgeSetNode;
+// Index used as the end of a linked list, or to mark that there is no node
+#define NO_NODE UINT32_MAX
 
 typedef struct EdgeSetNode
 {
     WEdge edge;
-    EdgeSetNode *next;
+    uint32_t next;
 } EdgeSetNode;
 
 typedef struct EdgeSet
@@ -53,8 +54,10 @@ typedef struct EdgeSet
     int label_a;
     int label_b;
     int number;
-    EdgeSetNode *first;
-    EdgeSetNode *last;
+    // Number of edges in the set, kept up to date while splicing so counting needs no list walk
+    int size;
+    uint32_t first;
+    uint32_t last;
 } EdgeSet;
 
 EdgeSet es_new(int label_a, int label_b)
@@ -63,180 +66,44 @@ EdgeSet es_new(int label_a, int label_b)
     edge_set.label_a = label_a;
     edge_set.label_b = label_b;
     edge_set.number = edge_number(label_a, label_b);
-    edge_set.first = NULL;
-    edge_set.last = NULL;
+    edge_set.size = 0;
+    edge_set.first = NO_NODE;
+    edge_set.last = NO_NODE;
     return edge_set;
 }
 
-void print_edge_set(EdgeSet *edge_set, bool print_fl)
-{
-    printf("Edgeset ( %d, %d):", edge_set->label_a, edge_set->label_b);
-
-    if (print_fl)
-    {
-        printf(" f: ");
-        if (edge_set->first == NULL)
-        {
-            printf("NULL");
-        }
-        else
-        {
-            printf("(%d, %d)", edge_set->first->edge.label_a, edge_set->first->edge.label_b);
-        }
-
-        printf(" l: ");
-        if (edge_set->last == NULL)
-        {
-            printf("NULL");
-        }
-        else
-        {
-            printf("(%d, %d)", edge_set->last->edge.label_a, edge_set->last->edge.label_b);
-        }
-    }
-
-    printf(" s:{");
-    EdgeSetNode *node = edge_set->first;
-    while (node != NULL)
-    {
-        WEdge edge = node->edge;
-        printf(" (%d, %d)", edge.label_a, edge.label_b);
-
-        node = node->next;
-    }
-    printf("}");
-}
-
-void es_add_edge(EdgeSet *es, WEdge edge)
-{
-    EdgeSetNode *node = malloc(sizeof(EdgeSetNode));
-    node->edge = edge;
-    node->next = NULL;
-
-    EdgeSetNode *start_node = es->first;
-
-    if (start_node == NULL)
-    {
-        es->first = node;
-        es->last = node;
-    }
-    else
-    {
-        EdgeSetNode *last_node = es->last;
-
-        last_node->next = node;
-        es->last = node;
-    }
-}
-
-void es_add_edge_set(EdgeSet *es, EdgeSet *es_to_add)
-{
-    EdgeSetNode *first_to_add = es_to_add->first;
-    EdgeSetNode *last_to_add = es_to_add->last;
-    EdgeSetNode *last_node = es->last;
-
-    if (last_node == NULL)
-    {
-        es->first = first_to_add;
-        es->last = last_to_add;
-    }
-    else
-    {
-        es->last->next = first_to_add;
-        es->last = last_to_add;
-    }
-}
-
-void es_clear(EdgeSet *es)
-{
-    es->first = NULL;
-    es->last = NULL;
-}
-
-typedef struct EdgeSetListNode EdgeSetListNode;
-
 typedef struct EdgeSetListNode
 {
-    EdgeSetListNode *previous;
-    EdgeSetListNode *next;
-    EdgeSet *edge_set;
+    uint32_t previous;
+    uint32_t next;
+    // Number of the edge set this node refers to
+    uint32_t edge_set;
 } EdgeSetListNode;
 
 typedef struct EdgeSetList
 {
     int label;
-    EdgeSetListNode *first;
-    EdgeSetListNode *last;
-    EdgeSetListNode *rank_node;
-    EdgeSetListNode *max_node;
+    uint32_t first;
+    uint32_t last;
+    uint32_t rank_node;
+    uint32_t max_node;
 } EdgeSetList;
 
 EdgeSetList esl_new(int label)
 {
     EdgeSetList edge_set_list;
-    edge_set_list.first = NULL;
-    edge_set_list.last = NULL;
+    edge_set_list.first = NO_NODE;
+    edge_set_list.last = NO_NODE;
     edge_set_list.label = label;
-    edge_set_list.rank_node = NULL;
-    edge_set_list.max_node = NULL;
+    edge_set_list.rank_node = NO_NODE;
+    edge_set_list.max_node = NO_NODE;
     return edge_set_list;
 }
 
-void esl_add_edgeset(EdgeSetList *edge_set_list, EdgeSet *edge_set)
-{
-    EdgeSetListNode *node = malloc(sizeof(EdgeSetListNode));
-    node->edge_set = edge_set;
-    node->previous = NULL;
-    node->next = NULL;
-
-    if (edge_set_list->last == NULL)
-    {
-        edge_set_list->first = node;
-        edge_set_list->last = node;
-    }
-    else
-    {
-        EdgeSetListNode *end_node = edge_set_list->last;
-        end_node->next = node;
-        node->previous = end_node;
-        edge_set_list->last = node;
-    }
-
-    if (edge_set_list->max_node == NULL || edge_set_list->max_node->edge_set->label_b < node->edge_set->label_b)
-    {
-        edge_set_list->max_node = node;
-    }
-}
-
-void esl_remove_edgeset(EdgeSetList *esl, EdgeSet *edge_set)
-{
-    EdgeSetListNode *node = esl->first;
-    while (node != NULL && node->edge_set != edge_set)
-        node = node->next;
-
-    if (node->previous == NULL)
-    {
-        esl->first = node->next;
-        esl->first->previous = NULL;
-    }
-    else if (node->next == NULL)
-    {
-        esl->last = node->previous;
-        esl->last->next = NULL;
-    }
-    else
-    {
-        node->previous->next = node->next;
-        node->next->previous = node->previous;
-    }
-
-    free(node);
-}
-
 typedef union WStackElement
 {
-    EdgeSetNode *esn;
-    EdgeSetListNode *esln;
+    uint32_t esn;
+    uint32_t esln;
 } WStackElement;
 
 typedef struct WStack
@@ -271,6 +138,50 @@ WStackElement stack_pop(WStack *stack)
     return stack->stack[--stack->size];
 }
 
+// Tree degrees of all labels capped at 3, two bits per label.
+// Capping loses nothing for HISTs as a degree of 3 or more can never drop back to 2.
+typedef struct DegreeState
+{
+    // Labels 0 to 31
+    uint64_t low;
+    // Labels 32 to 63
+    uint64_t high;
+} DegreeState;
+
+typedef struct HistMemoEntry
+{
+    DegreeState state;
+    unsigned int level;
+    unsigned int generation;
+    unsigned long long int count;
+} HistMemoEntry;
+
+// Number of entries in the memo table, must be a power of two
+#define HIST_MEMO_SIZE (1 << 14)
+// Only memoize levels where the remaining product of set sizes is at least this large
+#define HIST_MEMO_MIN_PRODUCT 16
+
+// Data used to count the HISTs in the Cartesian product of the contracted sets.
+// Levels are the indices of the contracted sets, they are expanded from n - 1 down to 1.
+typedef struct HistCounter
+{
+    // Current tree degree for each label
+    int *degrees;
+    // Lowest level whose set contains an edge incident to the label, after it the degree is final
+    int *last_level;
+    // Labels whose degree becomes final at each level, stored per level starting at final_offsets[level]
+    int *final_labels;
+    int *final_offsets;
+    // Labels which still appear in the sets at or below each level
+    DegreeState *open_masks;
+    // Product of the set sizes at or below each level, capped at HIST_MEMO_MIN_PRODUCT
+    int *remaining_products;
+    DegreeState state;
+    // Direct mapped cache of counts, entries from earlier leaves are invalidated through the generation
+    HistMemoEntry *memo;
+    unsigned int generation;
+} HistCounter;
+
 typedef struct WGraph
 {
     // Static value with the number of vertices in the graph
@@ -283,12 +194,25 @@ typedef struct WGraph
     EdgeSet *edge_sets;
 
     EdgeSetList *edge_set_lists;
+    // Pool holding every EdgeSetNode, one per edge of the input graph.
+    // Contracting only relinks these nodes, so none are created during the search.
+    EdgeSetNode *edge_set_nodes;
+    uint32_t nb_edge_set_nodes;
+    // Pool holding the EdgeSetListNodes, unused nodes are linked through next starting at free_list_node.
+    // An edge set is in at most one list at a time, so total_edges(n) nodes always suffice.
+    EdgeSetListNode *list_nodes;
+    uint32_t free_list_node;
     // Number of completed contractions
     int contractions;
 
     EdgeSet **contracted_sets;
 
     WStack stack;
+
+    HistCounter counter;
+
+    // When set, every leaf of the contraction is written here as a product of edge sets
+    FILE *factored_output;
 } WGraph;
 
 void free_wgraph(WGraph *graph)
@@ -300,41 +224,183 @@ void free_wgraph(WGraph *graph)
     }
     free(graph->vertices);
 
-    // Free edge sets
-    for (int i = 0; i < total_edges(graph->nb_vertices); i++)
+    // Free edge sets, edge set lists and their node pools
+    free(graph->edge_sets);
+    free(graph->edge_set_lists);
+    free(graph->edge_set_nodes);
+    free(graph->list_nodes);
+
+    // Free hist counter
+    free(graph->counter.degrees);
+    free(graph->counter.last_level);
+    free(graph->counter.final_labels);
+    free(graph->counter.final_offsets);
+    free(graph->counter.open_masks);
+    free(graph->counter.remaining_products);
+    free(graph->counter.memo);
+
+    // Free leftover arrays
+    free(graph->stack.stack);
+    free(graph->contracted_sets);
+    free(graph->labeling);
+    free(graph);
+}
+
+void print_edge_set(WGraph *graph, EdgeSet *edge_set, bool print_fl)
+{
+    EdgeSetNode *nodes = graph->edge_set_nodes;
+
+    printf("Edgeset ( %d, %d):", edge_set->label_a, edge_set->label_b);
+
+    if (print_fl)
     {
-        EdgeSet edge_set = graph->edge_sets[i];
-        EdgeSetNode *node = edge_set.first;
+        printf(" f: ");
+        if (edge_set->first == NO_NODE)
+        {
+            printf("NULL");
+        }
+        else
+        {
+            printf("(%d, %d)", nodes[edge_set->first].edge.label_a, nodes[edge_set->first].edge.label_b);
+        }
 
-        while (node != NULL)
+        printf(" l: ");
+        if (edge_set->last == NO_NODE)
+        {
+            printf("NULL");
+        }
+        else
         {
-            EdgeSetNode *old_node = node;
-            node = node->next;
-            free(old_node);
+            printf("(%d, %d)", nodes[edge_set->last].edge.label_a, nodes[edge_set->last].edge.label_b);
         }
     }
-    free(graph->edge_sets);
 
-    // Free edge set lists
-    for (int i = 0; i < graph->nb_vertices; i++)
+    printf(" s:{");
+    uint32_t node = edge_set->first;
+    while (node != NO_NODE)
     {
-        EdgeSetList esl = graph->edge_set_lists[i];
-        EdgeSetListNode *node = esl.first;
+        WEdge edge = nodes[node].edge;
+        printf(" (%d, %d)", edge.label_a, edge.label_b);
 
-        while (node != NULL)
-        {
-            EdgeSetListNode *old_node = node;
-            node = node->next;
-            free(old_node);
-        }
+        node = nodes[node].next;
     }
-    free(graph->edge_set_lists);
+    printf("}");
+}
 
-    // Free leftover arrays
-    free(graph->stack.stack);
-    free(graph->contracted_sets);
-    free(graph->labeling);
-    free(graph);
+void es_add_edge(WGraph *graph, EdgeSet *es, WEdge edge)
+{
+    if (graph->nb_edge_set_nodes >= total_edges(graph->nb_vertices))
+    {
+        fprintf(stderr, "Edge set node pool exhausted. This should never happen.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    uint32_t node = graph->nb_edge_set_nodes++;
+    graph->edge_set_nodes[node].edge = edge;
+    graph->edge_set_nodes[node].next = NO_NODE;
+
+    if (es->first == NO_NODE)
+    {
+        es->first = node;
+        es->last = node;
+    }
+    else
+    {
+        graph->edge_set_nodes[es->last].next = node;
+        es->last = node;
+    }
+
+    es->size += 1;
+}
+
+void es_add_edge_set(WGraph *graph, EdgeSet *es, EdgeSet *es_to_add)
+{
+    if (es->last == NO_NODE)
+    {
+        es->first = es_to_add->first;
+        es->last = es_to_add->last;
+    }
+    else
+    {
+        graph->edge_set_nodes[es->last].next = es_to_add->first;
+        es->last = es_to_add->last;
+    }
+
+    es->size += es_to_add->size;
+}
+
+void es_clear(EdgeSet *es)
+{
+    es->size = 0;
+    es->first = NO_NODE;
+    es->last = NO_NODE;
+}
+
+int esl_node_label_b(WGraph *graph, uint32_t node)
+{
+    return graph->edge_sets[graph->list_nodes[node].edge_set].label_b;
+}
+
+void esl_add_edgeset(WGraph *graph, EdgeSetList *edge_set_list, EdgeSet *edge_set)
+{
+    uint32_t node = graph->free_list_node;
+
+    if (node == NO_NODE)
+    {
+        fprintf(stderr, "Edge set list node pool exhausted. This should never happen.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    EdgeSetListNode *nodes = graph->list_nodes;
+    graph->free_list_node = nodes[node].next;
+
+    nodes[node].edge_set = edge_set->number;
+    nodes[node].previous = NO_NODE;
+    nodes[node].next = NO_NODE;
+
+    if (edge_set_list->last == NO_NODE)
+    {
+        edge_set_list->first = node;
+        edge_set_list->last = node;
+    }
+    else
+    {
+        uint32_t end_node = edge_set_list->last;
+        nodes[end_node].next = node;
+        nodes[node].previous = end_node;
+        edge_set_list->last = node;
+    }
+
+    if (edge_set_list->max_node == NO_NODE || esl_node_label_b(graph, edge_set_list->max_node) < edge_set->label_b)
+    {
+        edge_set_list->max_node = node;
+    }
+}
+
+void esl_remove_edgeset(WGraph *graph, EdgeSetList *esl, EdgeSet *edge_set)
+{
+    EdgeSetListNode *nodes = graph->list_nodes;
+
+    uint32_t node = esl->first;
+    while (node != NO_NODE && nodes[node].edge_set != edge_set->number)
+        node = nodes[node].next;
+
+    uint32_t previous = nodes[node].previous;
+    uint32_t next = nodes[node].next;
+
+    if (previous == NO_NODE)
+        esl->first = next;
+    else
+        nodes[previous].next = next;
+
+    if (next == NO_NODE)
+        esl->last = previous;
+    else
+        nodes[next].previous = previous;
+
+    // Return the node to the pool
+    nodes[node].next = graph->free_list_node;
+    graph->free_list_node = node;
 }
 
 void generate_labeling(WGraph *graph)
@@ -418,6 +484,17 @@ void initialize_edges(WGraph *graph)
     graph->edge_sets = calloc(nb_edges, sizeof(EdgeSet));
     graph->edge_set_lists = calloc(graph->nb_vertices, sizeof(EdgeSetList));
 
+    // Allocate node pools, every list node starts out unused
+    graph->edge_set_nodes = calloc(nb_edges, sizeof(EdgeSetNode));
+    graph->nb_edge_set_nodes = 0;
+    graph->list_nodes = calloc(nb_edges, sizeof(EdgeSetListNode));
+    graph->free_list_node = nb_edges > 0 ? 0 : NO_NODE;
+
+    for (int i = 0; i < nb_edges; i++)
+    {
+        graph->list_nodes[i].next = i + 1 < nb_edges ? i + 1 : NO_NODE;
+    }
+
     // Initialize arrays
     for (int label_a = 1; label_a < graph->nb_vertices; label_a++)
     {
@@ -453,12 +530,26 @@ void initialize_edges(WGraph *graph)
 
             EdgeSet *edge_set = &graph->edge_sets[edge_nb];
 
-            es_add_edge(edge_set, edge);
-            esl_add_edgeset(esl, edge_set);
+            es_add_edge(graph, edge_set, edge);
+            esl_add_edgeset(graph, esl, edge_set);
         }
     }
 }
 
+HistCounter hist_counter_new(int nb_vertices)
+{
+    HistCounter counter;
+    counter.degrees = calloc(nb_vertices, sizeof(int));
+    counter.last_level = calloc(nb_vertices, sizeof(int));
+    counter.final_labels = calloc(nb_vertices, sizeof(int));
+    counter.final_offsets = calloc(nb_vertices + 1, sizeof(int));
+    counter.open_masks = calloc(nb_vertices, sizeof(DegreeState));
+    counter.remaining_products = calloc(nb_vertices, sizeof(int));
+    counter.memo = calloc(HIST_MEMO_SIZE, sizeof(HistMemoEntry));
+    counter.generation = 0;
+    return counter;
+}
+
 WGraph *construct_wgraph(Graph *input_graph)
 {
     WGraph *wgraph = malloc(sizeof(WGraph));
@@ -497,6 +588,8 @@ WGraph *construct_wgraph(Graph *input_graph)
     initialize_edges(wgraph);
 
     wgraph->stack = wstack_new(wgraph->nb_vertices);
+    wgraph->counter = hist_counter_new(wgraph->nb_vertices);
+    wgraph->factored_output = NULL;
 
     return wgraph;
 }
@@ -507,27 +600,27 @@ void print_edge_sets(WGraph *graph)
     {
         EdgeSet set = graph->edge_sets[edge_nb];
 
-        print_edge_set(&set, false);
+        print_edge_set(graph, &set, false);
     }
 }
 
-void print_edge_set_list_node(EdgeSetListNode *node)
+void print_edge_set_list_node(WGraph *graph, uint32_t node)
 {
-    EdgeSet *edge_set = node->edge_set;
+    EdgeSet *edge_set = &graph->edge_sets[graph->list_nodes[node].edge_set];
     printf("  ");
-    print_edge_set(edge_set, false);
+    print_edge_set(graph, edge_set, false);
 }
 
-void print_edge_set_list(EdgeSetList *list)
+void print_edge_set_list(WGraph *graph, EdgeSetList *list)
 {
-    EdgeSetListNode *node = list->first;
+    uint32_t node = list->first;
 
-    printf("ESL  %d:\n", node->edge_set->label_a);
+    printf("ESL  %d:\n", list->label);
 
-    while (node != NULL)
+    while (node != NO_NODE)
     {
-        print_edge_set_list_node(node);
-        node = node->next;
+        print_edge_set_list_node(graph, node);
+        node = graph->list_nodes[node].next;
     }
 
     printf("\n");
@@ -538,27 +631,18 @@ void print_edge_set_lists(WGraph *graph)
     for (int label_a = 1; label_a < graph->nb_vertices; label_a++)
     {
         EdgeSetList *list = &graph->edge_set_lists[label_a];
-        print_edge_set_list(list);
+        print_edge_set_list(graph, list);
     }
 }
 
 void count_trees(WGraph *graph, unsigned long long int *nb_trees)
 {
-    int total_trees = 1;
+    unsigned long long int total_trees = 1;
 
     for (int i = graph->nb_vertices - 1; i > 0; i--)
     {
         EdgeSet *set = graph->contracted_sets[i];
-
-        EdgeSetNode *node = set->first;
-        int edges = 0;
-        while (node != NULL)
-        {
-            edges += 1;
-            node = node->next;
-        }
-
-        total_trees *= edges;
+        total_trees *= set->size;
     }
 
     *nb_trees += total_trees;
@@ -573,11 +657,11 @@ void count_trees_produced_parts(WGraph *graph, Graph *tree, int i, unsigned long
     }
 
     EdgeSet *set = graph->contracted_sets[i];
-    EdgeSetNode *node = set->first;
+    uint32_t node = set->first;
 
-    while (node != NULL)
+    while (node != NO_NODE)
     {
-        WEdge wedge = node->edge;
+        WEdge wedge = graph->edge_set_nodes[node].edge;
         Edge edge;
         edge.origin = graph->labeling[wedge.label_a]->index;
         edge.destination = graph->labeling[wedge.label_b]->index;
@@ -586,7 +670,7 @@ void count_trees_produced_parts(WGraph *graph, Graph *tree, int i, unsigned long
         count_trees_produced_parts(graph, tree, i - 1, nb_trees);
         remove_edge_from_graph(tree, &edge);
 
-        node = node->next;
+        node = graph->edge_set_nodes[node].next;
     }
 }
 
@@ -597,56 +681,175 @@ void count_trees_produced(WGraph *graph, unsigned long long int *nb_trees)
     free_graph(tree);
 }
 
-bool is_hist(Graph *potential_hist)
+void ds_set(DegreeState *state, int label, int degree)
+{
+    uint64_t *word = label < 32 ? &state->low : &state->high;
+    int shift = 2 * (label & 31);
+    uint64_t capped = degree < 3 ? degree : 3;
+
+    *word = (*word & ~(3ULL << shift)) | (capped << shift);
+}
+
+void ds_set_open(DegreeState *state, int label)
+{
+    ds_set(state, label, 3);
+}
+
+DegreeState ds_and(DegreeState a, DegreeState b)
+{
+    DegreeState result;
+    result.low = a.low & b.low;
+    result.high = a.high & b.high;
+    return result;
+}
+
+uint64_t ds_hash(DegreeState state, int level)
+{
+    uint64_t hash = state.low * 0x9E3779B97F4A7C15ULL;
+    hash ^= (state.high + level) * 0xC2B2AE3D27D4EB4FULL;
+    return hash ^ (hash >> 29);
+}
+
+void hc_add_degree(HistCounter *counter, int label)
+{
+    counter->degrees[label] += 1;
+    ds_set(&counter->state, label, counter->degrees[label]);
+}
+
+void hc_remove_degree(HistCounter *counter, int label)
 {
-    if (potential_hist->edges != potential_hist->vertices - 1)
+    counter->degrees[label] -= 1;
+    ds_set(&counter->state, label, counter->degrees[label]);
+}
+
+// Computes when the degree of every label becomes final and which parts of the product
+// are large enough to be memoized
+void hc_prepare(WGraph *graph)
+{
+    HistCounter *counter = &graph->counter;
+    EdgeSetNode *nodes = graph->edge_set_nodes;
+    int n = graph->nb_vertices;
+
+    for (int label = 0; label < n; label++)
     {
-        printf("Number of edges is incorrect. This should never happen.\n");
-        exit(EXIT_FAILURE);
+        counter->degrees[label] = 0;
+        counter->last_level[label] = 0;
+    }
+
+    // Scanning upwards, the first level a label is seen at is its lowest one
+    for (int level = 1; level < n; level++)
+    {
+        uint32_t node = graph->contracted_sets[level]->first;
+
+        while (node != NO_NODE)
+        {
+            WEdge wedge = nodes[node].edge;
+
+            if (counter->last_level[wedge.label_a] == 0)
+                counter->last_level[wedge.label_a] = level;
+            if (counter->last_level[wedge.label_b] == 0)
+                counter->last_level[wedge.label_b] = level;
+
+            node = nodes[node].next;
+        }
+    }
+
+    // Group labels by the level at which they become final
+    int nb_final = 0;
+    for (int level = 0; level < n; level++)
+    {
+        counter->final_offsets[level] = nb_final;
+
+        for (int label = 0; label < n; label++)
+        {
+            if (counter->last_level[label] == level)
+                counter->final_labels[nb_final++] = label;
+        }
     }
+    counter->final_offsets[n] = nb_final;
 
-    for (int i = 0; i < potential_hist->vertices; i++)
+    DegreeState open = {0, 0};
+    int product = 1;
+    for (int level = 1; level < n; level++)
     {
-        uint64_t adjacencies = potential_hist->adjacency_matrix[i];
-        if (vertex_degree(adjacencies) == 2)
-            return false;
+        for (int i = counter->final_offsets[level]; i < counter->final_offsets[level + 1]; i++)
+            ds_set_open(&open, counter->final_labels[i]);
+
+        counter->open_masks[level] = open;
+
+        product *= graph->contracted_sets[level]->size;
+        if (product > HIST_MEMO_MIN_PRODUCT)
+            product = HIST_MEMO_MIN_PRODUCT;
+        counter->remaining_products[level] = product;
     }
 
-    return true;
+    counter->state.low = 0;
+    counter->state.high = 0;
+    counter->generation += 1;
 }
 
-void count_hists_parts(WGraph *graph, Graph *potential_hist, int i, unsigned long long int *nb_hists)
+// Counts the HISTs among all choices of one edge from each of the sets at or below level.
+// A branch is cut as soon as the degree of a label that became final is 2.
+unsigned long long int hc_count_level(WGraph *graph, int level)
 {
-    if (i == 0)
+    if (level == 0)
+        return 1;
+
+    HistCounter *counter = &graph->counter;
+    HistMemoEntry *entry = NULL;
+    DegreeState key;
+
+    if (counter->remaining_products[level] >= HIST_MEMO_MIN_PRODUCT)
     {
-        if (is_hist(potential_hist))
-            *nb_hists += 1;
-        return;
+        key = ds_and(counter->state, counter->open_masks[level]);
+        entry = &counter->memo[ds_hash(key, level) & (HIST_MEMO_SIZE - 1)];
+
+        if (entry->generation == counter->generation && entry->level == level && entry->state.low == key.low && entry->state.high == key.high)
+            return entry->count;
     }
 
-    EdgeSet *set = graph->contracted_sets[i];
-    EdgeSetNode *node = set->first;
+    unsigned long long int total = 0;
+    int final_start = counter->final_offsets[level];
+    int final_end = counter->final_offsets[level + 1];
+
+    EdgeSetNode *nodes = graph->edge_set_nodes;
+    uint32_t node = graph->contracted_sets[level]->first;
 
-    while (node != NULL)
+    while (node != NO_NODE)
     {
-        WEdge wedge = node->edge;
-        Edge edge;
-        edge.origin = graph->labeling[wedge.label_a]->index;
-        edge.destination = graph->labeling[wedge.label_b]->index;
+        WEdge wedge = nodes[node].edge;
+
+        hc_add_degree(counter, wedge.label_a);
+        hc_add_degree(counter, wedge.label_b);
+
+        bool possible = true;
+        for (int i = final_start; i < final_end && possible; i++)
+            possible = counter->degrees[counter->final_labels[i]] != 2;
+
+        if (possible)
+            total += hc_count_level(graph, level - 1);
+
+        hc_remove_degree(counter, wedge.label_a);
+        hc_remove_degree(counter, wedge.label_b);
 
-        add_edge_to_graph(potential_hist, &edge);
-        count_hists_parts(graph, potential_hist, i - 1, nb_hists);
-        remove_edge_from_graph(potential_hist, &edge);
+        node = nodes[node].next;
+    }
 
-        node = node->next;
+    if (entry)
+    {
+        entry->state = key;
+        entry->level = level;
+        entry->generation = counter->generation;
+        entry->count = total;
     }
+
+    return total;
 }
 
 void count_hists(WGraph *graph, unsigned long long int *nb_hists)
 {
-    Graph *potential_hist = empty_graph(graph->nb_vertices);
-    count_hists_parts(graph, potential_hist, graph->nb_vertices - 1, nb_hists);
-    free_graph(potential_hist);
+    hc_prepare(graph);
+    *nb_hists += hc_count_level(graph, graph->nb_vertices - 1);
 }
 
 void print_contracted_sets(WGraph *graph)
@@ -657,19 +860,38 @@ void print_contracted_sets(WGraph *graph)
     {
         EdgeSet *set = graph->contracted_sets[i];
 
-        EdgeSetNode *node = set->first;
-        while (node != NULL)
-        {
-            node = node->next;
-        }
-
-        print_edge_set(set, false);
+        print_edge_set(graph, set, false);
         printf("; ");
     }
 
     printf("\n");
 }
 
+// Writes the trees of the current leaf as one line: the number of vertices followed by
+// the contracted sets separated by spaces, each set a comma separated list of edges
+// 'origin-destination' in original vertex indices. A tree takes exactly one edge from every set.
+void print_contracted_sets_factored(WGraph *graph, FILE *output)
+{
+    fprintf(output, "%d", graph->nb_vertices);
+
+    for (int i = graph->nb_vertices - 1; i > 0; i--)
+    {
+        uint32_t node = graph->contracted_sets[i]->first;
+        char separator = ' ';
+
+        while (node != NO_NODE)
+        {
+            WEdge wedge = graph->edge_set_nodes[node].edge;
+            fprintf(output, "%c%d-%d", separator, graph->labeling[wedge.label_a]->index, graph->labeling[wedge.label_b]->index);
+            separator = ',';
+
+            node = graph->edge_set_nodes[node].next;
+        }
+    }
+
+    fprintf(output, "\n");
+}
+
 void print_contracted_sets_g6_parts(WGraph *graph, Graph *tree, int i)
 {
     if (i == 0)
@@ -679,11 +901,11 @@ void print_contracted_sets_g6_parts(WGraph *graph, Graph *tree, int i)
     }
 
     EdgeSet *set = graph->contracted_sets[i];
-    EdgeSetNode *node = set->first;
+    uint32_t node = set->first;
 
-    while (node != NULL)
+    while (node != NO_NODE)
     {
-        WEdge wedge = node->edge;
+        WEdge wedge = graph->edge_set_nodes[node].edge;
         Edge edge;
         edge.origin = graph->labeling[wedge.label_a]->index;
         edge.destination = graph->labeling[wedge.label_b]->index;
@@ -692,7 +914,7 @@ void print_contracted_sets_g6_parts(WGraph *graph, Graph *tree, int i)
         print_contracted_sets_g6_parts(graph, tree, i - 1);
         remove_edge_from_graph(tree, &edge);
 
-        node = node->next;
+        node = graph->edge_set_nodes[node].next;
     }
 }
 
@@ -703,34 +925,36 @@ void print_contracted_sets_g6(WGraph *graph)
     free(tree);
 }
 
-void esl_rearrange(EdgeSetList *esl, EdgeSetListNode *rnk)
+void esl_rearrange(WGraph *graph, EdgeSetList *esl, uint32_t rnk)
 {
+    EdgeSetListNode *nodes = graph->list_nodes;
+
     // Pop rnk out of the double linked list
 
     // rnk is the only element in the list, no point in rearranging
-    if (rnk->previous == NULL && rnk->next == NULL)
+    if (nodes[rnk].previous == NO_NODE && nodes[rnk].next == NO_NODE)
         return;
 
     // rnk is last in the list
-    if (rnk->next == NULL) // && rnk->previous != NULL
+    if (nodes[rnk].next == NO_NODE) // && rnk->previous != NULL
     {
-        EdgeSetListNode *previous = rnk->previous;
+        uint32_t previous = nodes[rnk].previous;
         esl->last = previous;
-        previous->next = NULL;
+        nodes[previous].next = NO_NODE;
     }
     // rnk is first in the list
-    else if (rnk->previous == NULL) // && rnk->next != NULL
+    else if (nodes[rnk].previous == NO_NODE) // && rnk->next != NULL
     {
-        EdgeSetListNode *next = rnk->next;
+        uint32_t next = nodes[rnk].next;
         esl->first = next;
-        next->previous = NULL;
+        nodes[next].previous = NO_NODE;
     }
     else // rnk->next != NULL && rnk-> previous != NULL
     {
-        EdgeSetListNode *next = rnk->next;
-        EdgeSetListNode *previous = rnk->previous;
-        next->previous = previous;
-        previous->next = next;
+        uint32_t next = nodes[rnk].next;
+        uint32_t previous = nodes[rnk].previous;
+        nodes[next].previous = previous;
+        nodes[previous].next = next;
     }
 
     // Place rnk in the correct position
@@ -738,102 +962,102 @@ void esl_rearrange(EdgeSetList *esl, EdgeSetListNode *rnk)
     // rnk is largest so pop it in the back
     if (rnk == esl->max_node)
     {
-        rnk->previous = esl->last;
+        nodes[rnk].previous = esl->last;
         esl->last = rnk;
-        rnk->previous->next = rnk;
-        rnk->next = NULL;
+        nodes[nodes[rnk].previous].next = rnk;
+        nodes[rnk].next = NO_NODE;
     }
     // Place rmk before the previously processed set
     else
     {
-        rnk->previous = esl->rank_node->previous;
-        if (rnk->previous != NULL)
-            rnk->previous->next = rnk;
+        nodes[rnk].previous = nodes[esl->rank_node].previous;
+        if (nodes[rnk].previous != NO_NODE)
+            nodes[nodes[rnk].previous].next = rnk;
         else
             esl->first = rnk;
 
-        rnk->next = esl->rank_node;
-        rnk->next->previous = rnk;
+        nodes[rnk].next = esl->rank_node;
+        nodes[esl->rank_node].previous = rnk;
     }
 
     // rnk now becomes the last processed node
     esl->rank_node = rnk;
 }
 
-void scan_contract(WGraph *graph, EdgeSetList *eenk, EdgeSetListNode *rnk)
+void scan_contract(WGraph *graph, EdgeSetList *eenk, uint32_t rnk)
 {
-    int rnk_val = rnk->edge_set->label_b;
+    EdgeSetListNode *nodes = graph->list_nodes;
+    int rnk_val = esl_node_label_b(graph, rnk);
 
-    EdgeSetListNode *enki = eenk->first;
-    while (enki != NULL && enki != rnk)
+    uint32_t enki = eenk->first;
+    while (enki != NO_NODE && enki != rnk)
     {
-        int i = enki->edge_set->label_b;
+        EdgeSet *enki_set = &graph->edge_sets[nodes[enki].edge_set];
+        int i = enki_set->label_b;
         EdgeSet *ernki = &graph->edge_sets[edge_number(rnk_val, i)];
 
         // Set not empty
-        if (ernki->last != NULL)
+        if (ernki->last != NO_NODE)
         {
             WStackElement val;
             val.esn = ernki->last;
             stack_push(&graph->stack, val);
-            es_add_edge_set(ernki, enki->edge_set);
+            es_add_edge_set(graph, ernki, enki_set);
         }
         // Set empty
         else
         {
             EdgeSetList *eernk = &graph->edge_set_lists[rnk_val];
-            EdgeSetListNode *max_value_node = eernk->max_node;
+            uint32_t max_value_node = eernk->max_node;
 
-            es_add_edge_set(ernki, enki->edge_set);
-            esl_add_edgeset(eernk, ernki);
+            es_add_edge_set(graph, ernki, enki_set);
+            esl_add_edgeset(graph, eernk, ernki);
 
             WStackElement val;
             val.esln = max_value_node;
             stack_push(&graph->stack, val);
         }
 
-        enki = enki->next;
+        enki = nodes[enki].next;
     }
 }
 
-void scan_restore(WGraph *graph, EdgeSetListNode **rnk_ptr)
+void scan_restore(WGraph *graph, uint32_t *rnk_ptr)
 {
-    EdgeSetListNode *rnk = *rnk_ptr;
+    EdgeSetListNode *nodes = graph->list_nodes;
+    uint32_t rnk = *rnk_ptr;
 
-    int rnk_val = rnk->edge_set->label_b;
-    EdgeSetListNode *enki = rnk->previous;
+    int rnk_val = esl_node_label_b(graph, rnk);
+    uint32_t enki = nodes[rnk].previous;
 
     int max_i = -1;
-    EdgeSetListNode *max_i_node = NULL;
+    uint32_t max_i_node = NO_NODE;
 
-    while (enki != NULL)
+    while (enki != NO_NODE)
     {
-        int i = enki->edge_set->label_b;
-        EdgeSet *enki_set = enki->edge_set;
+        EdgeSet *enki_set = &graph->edge_sets[nodes[enki].edge_set];
+        int i = enki_set->label_b;
         EdgeSet *ernki_set = &graph->edge_sets[edge_number(rnk_val, i)];
 
-        EdgeSetNode *enki_first = enki_set->first;
-        EdgeSetNode *ernki_first = ernki_set->first;
-
-        if (enki_first != ernki_first)
+        if (enki_set->first != ernki_set->first)
         {
             WStackElement val = stack_pop(&graph->stack);
-            EdgeSetNode *last = val.esn;
-            if (last == NULL)
+            uint32_t last = val.esn;
+            if (last == NO_NODE)
             {
                 fprintf(stderr, "Last should not be NULL.\n");
                 exit(EXIT_FAILURE);
             }
             ernki_set->last = last;
-            last->next = NULL;
+            ernki_set->size -= enki_set->size;
+            graph->edge_set_nodes[last].next = NO_NODE;
         }
         else
         {
             EdgeSetList *eernk = &graph->edge_set_lists[rnk_val];
-            esl_remove_edgeset(eernk, ernki_set);
+            esl_remove_edgeset(graph, eernk, ernki_set);
             WStackElement val = stack_pop(&graph->stack);
-            EdgeSetListNode *eernk_max = val.esln;
-            eernk->max_node = eernk_max;
+            eernk->max_node = val.esln;
             es_clear(ernki_set);
         }
 
@@ -843,7 +1067,7 @@ void scan_restore(WGraph *graph, EdgeSetListNode **rnk_ptr)
             max_i_node = enki;
         }
 
-        enki = enki->previous;
+        enki = nodes[enki].previous;
     }
 
     *rnk_ptr = max_i_node;
@@ -861,6 +1085,11 @@ void contract(WGraph *graph, unsigned long long int *nb_trees, bool find_hists,
         graph->contracted_sets[nk] = &graph->edge_sets[0];
         if (find_hists)
             count_hists(graph, nb_trees);
+        else if (graph->factored_output)
+        {
+            print_contracted_sets_factored(graph, graph->factored_output);
+            count_trees(graph, nb_trees);
+        }
         else if (produce_trees)
             count_trees_produced(graph, nb_trees);
         else
@@ -874,13 +1103,13 @@ void contract(WGraph *graph, unsigned long long int *nb_trees, bool find_hists,
     EdgeSetList *eenk = &graph->edge_set_lists[nk]; // EE(n - k)
 
     // Keep track of the current edgeset we're contracting
-    EdgeSetListNode *rnk_node = eenk->max_node;
+    uint32_t rnk_node = eenk->max_node;
 
-    while (rnk_node != NULL)
+    while (rnk_node != NO_NODE)
     {
-        int rnk = rnk_node->edge_set->label_b; // r_n-k
+        int rnk = esl_node_label_b(graph, rnk_node); // r_n-k
 
-        esl_rearrange(eenk, rnk_node);
+        esl_rearrange(graph, eenk, rnk_node);
         scan_contract(graph, eenk, rnk_node);
 
         EdgeSet *contracted_set = &graph->edge_sets[edge_number(nk, rnk)];
@@ -894,9 +1123,10 @@ void contract(WGraph *graph, unsigned long long int *nb_trees, bool find_hists,
     }
 }
 
-unsigned long long int winter(Graph *graph, bool find_hists, bool produce_trees)
+unsigned long long int winter(Graph *graph, bool find_hists, bool produce_trees, FILE *factored_output)
 {
     WGraph *wgraph = construct_wgraph(graph);
+    wgraph->factored_output = factored_output;
     unsigned long long int nb_trees = 0;
     contract(wgraph, &nb_trees, find_hists, produce_trees);
     free_wgraph(wgraph);
@@ -911,6 +1141,7 @@ int main(int argc, char *argv[])
 
     bool find_hists = false;
     bool produce_trees = false;
+    bool factored = false;
 
     for (int i = 1; i < argc; i++)
     {
@@ -919,10 +1150,19 @@ int main(int argc, char *argv[])
 
         if (strcmp(argv[i], "out") == 0)
             produce_trees = true;
+
+        if (strcmp(argv[i], "factored") == 0)
+            factored = true;
     }
 
     if (find_hists)
+    {
         produce_trees = false;
+        factored = false;
+    }
+
+    // Factored trees are written to stdout, so the summary moves to stderr
+    FILE *summary = factored ? stderr : stdout;
 
     RunData *histg_data = rd_new();
 
@@ -942,7 +1182,7 @@ int main(int argc, char *argv[])
 
         // Time winter's algorithm
         start_timer(&timer);
-        unsigned long long int winter_nb = winter(graph, find_hists, produce_trees);
+        unsigned long long int winter_nb = winter(graph, find_hists, produce_trees, factored ? stdout : NULL);
         end_timer(&timer);
         winter_time += elapsed_time_seconds(&timer);
 
@@ -975,10 +1215,10 @@ int main(int argc, char *argv[])
         free_graph(graph);
     }
 
-    printf("Graphs: %llu", nb_graphs);
-    printf(find_hists ? ", hists: " : ", trees: ");
-    printf("%llu,", nb_trees);
-    printf(" winter time: %lf, histg time: %lf\n", winter_time, histg_time);
+    fprintf(summary, "Graphs: %llu", nb_graphs);
+    fprintf(summary, find_hists ? ", hists: " : ", trees: ");
+    fprintf(summary, "%llu,", nb_trees);
+    fprintf(summary, " winter time: %lf, histg time: %lf\n", winter_time, histg_time);
 
     free(line);
     free(histg_data);